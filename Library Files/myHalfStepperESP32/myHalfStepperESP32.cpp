@@ -66,7 +66,11 @@ void HalfStepper::SetDirection(Direction direction) { _Direction = direction; }
 
 Direction HalfStepper::GetDirection() const { return _Direction; }
 
-void HalfStepper::SetPosition(dword position) { _Position = position; }
+void HalfStepper::SetPosition(dword position)
+{
+	_Position = position;
+	_Phase = position & _PhaseMask;
+}
 
 dword HalfStepper::GetPosition() const { return _Position; }
 
@@ -99,14 +103,16 @@ void HalfStepper::Step(long numSteps)
 		{
 			if (_Position++ == _TotalSteps)
 				_Position = 0;
+			_Phase = (_Phase + 1) & _PhaseMask;
 		}
 		else
 		{
 			if (_Position-- == 0)
 				_Position = _TotalSteps;
+			_Phase = (_Phase - 1) & _PhaseMask;
 		}
 
-		this->DoStep(_Position % (_PinCount * 2));
+		this->DoStep(_Phase);
 	}
 }
 
@@ -150,11 +156,61 @@ void HalfStepper::UpdateSteps()
 				[BOOL_TO_INDEX((bool)_PhasingMode)][BOOL_TO_INDEX((bool)_SequenceType)][i]);
 		}
 	}
+
+	_PhaseMask = (_PinCount * 2) - 1;
+	_Phase = _Position & _PhaseMask;
+
+	// PRECOMPUTE THE PIN STATES OF EACH PHASE AS GPIO SET/CLEAR MASKS
+	// ESP8266 GPOS/GPOC COVER GPIO0-15, ESP32 out_w1ts/out_w1tc COVER GPIO0-31
+#if defined(ESP8266)
+	const byte maxFastPin = 16;
+#elif defined(ESP32)
+	const byte maxFastPin = 32;
+#else
+	const byte maxFastPin = 0;
+#endif
+	_FastPins = true;
+	for (int p = 0; p < _PinCount; p++)
+	{
+		if (_Pins[p] >= maxFastPin)
+			_FastPins = false;
+	}
+
+	for (int i = 0; i <= _PhaseMask; i++)
+	{
+		_SetMask[i] = 0;
+		_ClearMask[i] = 0;
+
+		for (int p = 0; p < _PinCount && _FastPins; p++)
+		{
+			if (_Steps[i] & (1 << (_PinCount - 1 - p)))
+				_SetMask[i] |= (dword)1 << _Pins[p];
+			else
+				_ClearMask[i] |= (dword)1 << _Pins[p];
+		}
+	}
 }
 
 // STEP EXECUTION METHOD
 void HalfStepper::DoStep(byte stepIdx)
 {
+	// ENERGISE THE NEW COILS BEFORE RELEASING THE OLD ONES SO THERE IS NO STATE WITH NO COILS ON
+#if defined(ESP8266)
+	if (_FastPins)
+	{
+		GPOS = _SetMask[stepIdx];
+		GPOC = _ClearMask[stepIdx];
+		return;
+	}
+#elif defined(ESP32)
+	if (_FastPins)
+	{
+		GPIO.out_w1ts = _SetMask[stepIdx];
+		GPIO.out_w1tc = _ClearMask[stepIdx];
+		return;
+	}
+#endif
+
 	if (_PinCount == 4)
 	{
 		digitalWrite(_Pins[0], _Steps[stepIdx] & B1000 ? HIGH : LOW);
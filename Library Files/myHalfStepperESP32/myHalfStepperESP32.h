@@ -29,6 +29,11 @@
 // ARDUINO LIBS
 #include "myStepperESP32.h"
 
+// GPIO REGISTERS FOR SINGLE WRITE PHASE CHANGES
+#if defined(ESP32)
+#include "soc/gpio_struct.h"
+#endif
+
 // PROGRAM OPTIONS
 #ifndef DEBUG_SERIAL
 	#define DEBUG_SERIAL	0
@@ -176,6 +181,15 @@ protected:
 	dword _Position = 0;
 	dword _LastStepMS = 0;
 
+	// COIL PHASE, WRAPPED WITH _PhaseMask AS THE SEQUENCE LENGTH IS A POWER OF TWO
+	byte _Phase = 0;
+	byte _PhaseMask = 7;
+
+	// PER-PHASE GPIO SET/CLEAR MASKS, USED WHEN ALL PINS ARE IN ONE GPIO REGISTER
+	bool _FastPins = false;
+	dword _SetMask[8];
+	dword _ClearMask[8];
+
 	// HELPER METHODS
 
 	// STEP SEQUENCE RETRIEVAL METHOD
@@ -0,0 +1,128 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP HOST BUILD - COMMAND DISPATCH BENCHMARK
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+// Host commands/sec of the tcp protocol path, frame parse, cmdtable dispatch, handler and reply,
+// driven by loop() with the poll mixes of Test-Programs/PROTOCOLBENCH. Heap allocations are counted
+// with a replacement operator new (String is a std::string in the host build), the frames are
+// queued and the reply buffer sized before counting so only the firmware's allocations are seen.
+// An idle loop() pass is measured the same way, the dispatch path must not allocate at all.
+//
+// Run:    ./bench_dispatch [commands]       default 200000
+
+#include <chrono>
+#include <new>
+#include <vector>
+#include "hosttest.h"
+#include "protocolmixes.h"
+
+extern void loop(void);
+
+static unsigned long allocations = 0;
+
+void *operator new(size_t size)
+{
+  allocations++;
+  void *p = malloc(size ? size : 1);
+  if ( p == nullptr )
+  {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void *operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+  free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+  free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+  free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+  free(p);
+}
+
+typedef std::chrono::steady_clock benchclock;
+
+int main(int argc, char *argv[])
+{
+  unsigned long n = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 200000;
+
+  simsetup();
+  printf("setup(): %lu allocations\n", allocations);
+  CHECK(allocations > 0);                       // the counter sees the firmware's String allocations
+  SimClient client = simconnect();
+  simrun(100);
+  client.reserve(n * 32);
+
+  // idle loop() passes, nothing to read
+  unsigned long before = allocations;
+  const unsigned long idlepasses = 10000;
+  for ( unsigned long i = 0; i < idlepasses; i++ )
+  {
+    loop();
+  }
+  unsigned long idleallocs = allocations - before;
+  printf("idle loop(): %lu passes, %lu allocations\n", idlepasses, idleallocs);
+  CHECKEQ(idleallocs, 0UL);
+
+  for ( const mix_t &mix : mixes )
+  {
+    std::string frames;
+    for ( unsigned long i = 0; i < n; i++ )
+    {
+      frames += ":";
+      int op = mix.opcodes[i % mix.opcodes.size()];
+      frames += (char) ('0' + op / 10);
+      frames += (char) ('0' + op % 10);
+      frames += "#";
+    }
+    client.send(frames);
+    client.discard();
+
+    before = allocations;
+    unsigned long passes = 0;
+    benchclock::time_point start = benchclock::now();
+    while ( client.pending() )
+    {
+      loop();
+      passes++;
+    }
+    double s = std::chrono::duration<double>(benchclock::now() - start).count();
+    unsigned long allocs = allocations - before;
+
+    std::string replies = client.receive();
+    unsigned long count = 0;
+    for ( char c : replies )
+    {
+      count += (c == '#') ? 1 : 0;
+    }
+    printf("%-7s %lu commands in %lu loop() passes, %.0f commands/s, %.3f allocations/command\n",
+           mix.name, n, passes, n / s, (double) allocs / n);
+    CHECKEQ(count, n);
+    CHECKEQ(allocs, 0UL);
+    client.reserve(n * 32);
+  }
+  return testresult("bench_dispatch");
+}
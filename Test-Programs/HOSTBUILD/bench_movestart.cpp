@@ -0,0 +1,79 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP HOST BUILD - MOVE START BENCHMARK
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+// Host wall time of the software part of a move start: from a :05xxxx# frame waiting on the tcp
+// connection to DriverBoard::initmove() being called, through the comms parser and the loop() state
+// machine (State_Idle, State_InitMove). The timer arm and the first STEP pulse are hardware and are
+// not in this number, on a board build with TIMEMOVESTART for the :05 to first step time.
+//
+// Run:    ./bench_movestart [moves]       default 2000
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "hosttest.h"
+#include "generalDefinitions.h"
+#include "simboard.h"
+
+extern void loop(void);
+
+typedef std::chrono::steady_clock benchclock;
+static benchclock::time_point moved;
+
+static void onmove(void)
+{
+  moved = benchclock::now();
+}
+
+int main(int argc, char *argv[])
+{
+  unsigned long n = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 2000;
+  std::vector<double> ns;
+  std::vector<unsigned long> passes;
+
+  simsetup();
+  SimClient client = simconnect();
+  simrun(10);
+  simboard.onmove = onmove;
+
+  for ( unsigned long i = 0; i < n; i++ )
+  {
+    unsigned long moves = simboard.moves;
+    client.send((i & 1) ? ":055000#" : ":055010#");
+    benchclock::time_point start = benchclock::now();
+    unsigned long p = 0;
+    while ( (simboard.moves == moves) && (p < 100) )
+    {
+      loop();
+      p++;
+    }
+    if ( simboard.moves == moves )
+    {
+      printf("move %lu did not start\n", i);
+      testfailures++;
+      break;
+    }
+    ns.push_back(std::chrono::duration<double, std::nano>(moved - start).count());
+    passes.push_back(p);
+    simrun(500);                                // finish the move and let the focuser settle
+    client.receive();
+  }
+
+  if ( !ns.empty() )
+  {
+    std::sort(ns.begin(), ns.end());
+    std::sort(passes.begin(), passes.end());
+    printf("move start, :05 frame to initmove(), %zu moves\n", ns.size());
+    printf("  p50 %.0f ns  p99 %.0f ns  max %.0f ns\n", ns[ns.size() / 2], ns[(ns.size() * 99) / 100], ns.back());
+    printf("  loop() passes: min %lu  max %lu\n", passes.front(), passes.back());
+  }
+  return testresult("bench_movestart");
+}
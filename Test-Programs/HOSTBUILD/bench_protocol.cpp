@@ -0,0 +1,227 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP HOST BUILD - PROTOCOL BENCHMARK
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+// Test-Programs/PROTOCOLBENCH run against the host build instead of a controller. The same poll
+// mixes are replayed through simulated tcp clients, one request outstanding per client, and loop()
+// runs until each reply is in. Reports p50/p99/max per opcode in host uS and loop() passes, for
+// ascii and binary frames, and the cost of a reconnect, a new client up to the :02# reply.
+// The times are the firmware's own work on the host, there is no network and no WiFi stack.
+//
+// Run:    ./bench_protocol [commands] [reconnects] [clients]     default 20000 20 1
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <vector>
+#include "hosttest.h"
+#include "protocolmixes.h"
+
+extern void loop(void);
+
+#define MAXPASSES             1000          // loop() passes to wait for a reply before counting an error
+
+typedef std::chrono::steady_clock benchclock;
+
+static double percentile(std::vector<double> &v, double p)
+{
+  if ( v.empty() )
+  {
+    return 0;
+  }
+  std::sort(v.begin(), v.end());
+  size_t idx = (size_t) (p * (v.size() - 1) + 0.5);
+  return v[idx];
+}
+
+struct benchclient_t
+{
+  SimClient client;
+  std::string reply;
+  bool done;
+  double us;
+  unsigned long passes;
+};
+
+// a whole reply is in, the ascii reply ends with #, a binary frame carries its length
+static bool replycomplete(const std::string &r, bool binary)
+{
+  if ( !binary )
+  {
+    return !r.empty() && (r.back() == '#');
+  }
+  if ( r.size() < BINHEADERSIZE )
+  {
+    return false;
+  }
+  size_t len = (uint8_t) r[3] | ((uint8_t) r[4] << 8);
+  return r.size() >= (BINHEADERSIZE + len + 2);
+}
+
+static bool replyvalid(const std::string &r, bool binary)
+{
+  if ( !binary )
+  {
+    return (r.size() > 1) && (r.find('#') == r.size() - 1);
+  }
+  const uint8_t *p = (const uint8_t *) r.data();
+  size_t len = p[3] | (p[4] << 8);
+  if ( (p[0] != BINSYNC) || (p[2] == BIN_ERROR) || (r.size() != BINHEADERSIZE + len + 2) )
+  {
+    return false;
+  }
+  uint16_t crc = crc16(0xFFFF, p + 1, BINHEADERSIZE - 1 + len);
+  return crc == (p[BINHEADERSIZE + len] | (p[BINHEADERSIZE + len + 1] << 8));
+}
+
+static void sendrequest(SimClient &client, int opcode, bool binary)
+{
+  if ( binary )
+  {
+    uint8_t frame[BINHEADERSIZE + 2];
+    binaryframe(opcode, frame);
+    client.send(frame, sizeof(frame));
+  }
+  else
+  {
+    char cmd[8];
+    snprintf(cmd, sizeof(cmd), ":%02d#", opcode);
+    client.send(cmd);
+  }
+}
+
+// every client sends its next request, then loop() runs until all replies are in
+static void runmix(const mix_t &mix, unsigned long n, int clients, bool binary)
+{
+  std::vector<benchclient_t> bc(clients);
+  for ( benchclient_t &c : bc )
+  {
+    c.client = simconnect();
+    if ( binary )
+    {
+      c.client.send(":591#");
+    }
+  }
+  simrun(10);
+
+  std::map<int, std::vector<double>> rtt;
+  std::map<int, std::vector<double>> passes;
+  unsigned long errors = 0;
+  unsigned long done = 0;
+  benchclock::time_point begin = benchclock::now();
+  for ( unsigned long i = 0; i < n; i++ )
+  {
+    int opcode = mix.opcodes[i % mix.opcodes.size()];
+    benchclock::time_point start = benchclock::now();
+    for ( benchclient_t &c : bc )
+    {
+      c.reply.clear();
+      c.done = false;
+      sendrequest(c.client, opcode, binary);
+    }
+    int waiting = clients;
+    for ( unsigned long pass = 1; (pass <= MAXPASSES) && waiting; pass++ )
+    {
+      loop();
+      for ( benchclient_t &c : bc )
+      {
+        if ( !c.done )
+        {
+          c.reply += c.client.receive();
+          if ( replycomplete(c.reply, binary) )
+          {
+            c.done = true;
+            c.us = std::chrono::duration<double, std::micro>(benchclock::now() - start).count();
+            c.passes = pass;
+            waiting--;
+          }
+        }
+      }
+    }
+    for ( benchclient_t &c : bc )
+    {
+      if ( c.done && replyvalid(c.reply, binary) )
+      {
+        rtt[opcode].push_back(c.us);
+        passes[opcode].push_back(c.passes);
+        done++;
+      }
+      else
+      {
+        errors++;
+      }
+    }
+  }
+  double s = std::chrono::duration<double>(benchclock::now() - begin).count();
+  for ( benchclient_t &c : bc )
+  {
+    c.client.close();
+  }
+  simrun(10);
+
+  printf("mix %s, %d client(s), %s frames\n", mix.name, clients, binary ? "binary" : "ascii");
+  printf("opcode  count     p50(us)   p99(us)   max(us)   p99(passes)\n");
+  for ( auto &r : rtt )
+  {
+    std::vector<double> &v = r.second;
+    std::sort(v.begin(), v.end());
+    printf(":%02d#   %-8zu  %-8.2f  %-8.2f  %-8.2f  %.0f\n", r.first, v.size(), percentile(v, 0.50),
+           percentile(v, 0.99), v.back(), percentile(passes[r.first], 0.99));
+  }
+  printf("commands/sec %.0f, errors %lu\n\n", done / s, errors);
+  CHECKEQ(errors, 0UL);
+  CHECKEQ(done, n * clients);
+}
+
+// connect and the first reply, the previous client is closed and its slot freed first
+static void runreconnects(int reconnects)
+{
+  std::vector<double> us;
+  std::vector<double> passes;
+  for ( int i = 0; i < reconnects; i++ )
+  {
+    benchclock::time_point start = benchclock::now();
+    SimClient client = simconnect();
+    client.send(":02#");
+    std::string reply;
+    for ( unsigned long pass = 1; pass <= MAXPASSES; pass++ )
+    {
+      loop();
+      reply += client.receive();
+      if ( replycomplete(reply, false) )
+      {
+        us.push_back(std::chrono::duration<double, std::micro>(benchclock::now() - start).count());
+        passes.push_back(pass);
+        break;
+      }
+    }
+    client.close();
+    simrun(50);                                   // let the firmware see the disconnect and free the slot
+  }
+  printf("reconnect    %zu ok, p50 %.2fus, p99 %.2fus, p99 %.0f loop() passes\n", us.size(),
+         percentile(us, 0.50), percentile(us, 0.99), percentile(passes, 0.99));
+  CHECKEQ(us.size(), (size_t) reconnects);
+}
+
+int main(int argc, char *argv[])
+{
+  unsigned long n = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 20000;
+  int reconnects = (argc > 2) ? atoi(argv[2]) : 20;
+  int clients = (argc > 3) ? atoi(argv[3]) : 1;
+
+  simsetup();
+  for ( const mix_t &mix : mixes )
+  {
+    runmix(mix, n, clients, false);
+    runmix(mix, n, clients, true);
+  }
+  runreconnects(reconnects);
+  return testresult("bench_protocol");
+}
@@ -0,0 +1,48 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP HOST BUILD - FIRMWARE
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+// The Arduino IDE compiles myFP2ESP.ino as C++, this does the same for the host build. setup() and
+// loop() are called by simsetup() and simrun() in hostsim.cpp. hostcmd() is for the tests.
+
+#include "myFP2ESP.ino"
+
+#include "hostcmd.h"
+
+int hostcmdcount(void)
+{
+  return CMDTABLESIZE;
+}
+
+hostcmd_t hostcmd(int opcode)
+{
+  hostcmd_t c;
+  c.supported = (cmdtable[opcode].handler != nullptr);
+  c.token = cmdtable[opcode].token;
+  switch ( cmdtable[opcode].argtype )
+  {
+    case CMDARG_DIGIT:
+      c.arg = HOSTCMDARG_DIGIT;
+      break;
+    case CMDARG_INT:
+      c.arg = HOSTCMDARG_INT;
+      break;
+    case CMDARG_FLOAT:
+      c.arg = HOSTCMDARG_FLOAT;
+      break;
+    case CMDARG_TEXT:
+      c.arg = HOSTCMDARG_TEXT;
+      break;
+    default:
+      c.arg = HOSTCMDARG_NONE;
+      break;
+  }
+  return c;
+}
@@ -0,0 +1,35 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP HOST BUILD - COMMAND TABLE ACCESS
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+// cmdtable in comms.h is local to the firmware translation unit, firmware.cpp copies an entry out
+// for the tests with hostcmd()
+
+#ifndef hostcmd_h
+#define hostcmd_h
+
+// argument the command expects, as cmdargtype in comms.h
+#define HOSTCMDARG_NONE       'n'
+#define HOSTCMDARG_DIGIT      'd'
+#define HOSTCMDARG_INT        'i'
+#define HOSTCMDARG_FLOAT      'f'
+#define HOSTCMDARG_TEXT       't'
+
+struct hostcmd_t
+{
+  bool supported;                               // entry has a handler
+  char token;                                   // reply token, 0 if the command does not reply
+  char arg;                                     // HOSTCMDARG_xxx
+};
+
+int hostcmdcount(void);
+hostcmd_t hostcmd(int opcode);
+
+#endif
@@ -0,0 +1,51 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP HOST BUILD - TEST HELPERS
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+#ifndef hosttest_h
+#define hosttest_h
+
+#include <stdio.h>
+#include <string>
+#include "hostsim.h"
+
+static int testfailures = 0;
+
+// report a failed check and carry on, main() returns testresult()
+#define CHECK(cond) \
+  do { if ( !(cond) ) { printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); testfailures++; } } while (0)
+
+#define CHECKEQ(a, b) \
+  do { if ( !((a) == (b)) ) { printf("%s:%d: CHECKEQ(%s, %s) failed\n", __FILE__, __LINE__, #a, #b); testfailures++; } } while (0)
+
+static inline int testresult(const char *name)
+{
+  printf("%s: %s\n", name, testfailures ? "FAILED" : "passed");
+  return testfailures ? 1 : 0;
+}
+
+// send a command to the focuser and run loop() until the reply is in, empty if there is none within ms
+static inline std::string command(SimClient &client, const std::string &cmd, unsigned long ms = 50)
+{
+  client.send(cmd);
+  std::string reply;
+  for ( unsigned long t = 0; t < ms; t++ )
+  {
+    simrun(1);
+    reply += client.receive();
+    if ( !reply.empty() && reply.back() == '#' && !client.pending() )
+    {
+      break;
+    }
+  }
+  return reply;
+}
+
+#endif
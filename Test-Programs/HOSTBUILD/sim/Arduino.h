@@ -0,0 +1,220 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP HOST BUILD - SIMULATED ARDUINO CORE
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+// The part of the Arduino core the focuser core uses, for a Linux build. Time is simulated, it only
+// moves on in delay() and simadvance() so a test runs the same way on every machine. String is a
+// real heap string so the host benchmarks see the allocations the firmware would make.
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <ctype.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH                  1
+#define LOW                   0
+#define INPUT                 0x00
+#define OUTPUT                0x01
+#define INPUT_PULLUP          0x02
+#define RISING                0x01
+#define FALLING               0x02
+#define CHANGE                0x03
+
+#define PROGMEM
+#define IRAM_ATTR
+#define ICACHE_RAM_ATTR
+#define F(s)                  (s)
+#define PSTR(s)               (s)
+#define memcpy_P              memcpy
+#define digitalPinToInterrupt(p)  (p)
+
+// ---------------------------------------------------------------------------
+// 1: TIME AND GPIO
+// ---------------------------------------------------------------------------
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield(void);
+
+void pinMode(uint8_t pin, uint8_t mode);
+int  digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t val);
+int  analogRead(uint8_t pin);
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode);
+void detachInterrupt(uint8_t pin);
+
+// ---------------------------------------------------------------------------
+// 2: NUMBER CONVERSIONS FROM THE AVR LIBC
+// ---------------------------------------------------------------------------
+char *ltoa(long val, char *s, int radix);
+char *ultoa(unsigned long val, char *s, int radix);
+char *itoa(int val, char *s, int radix);
+char *dtostrf(double val, signed char width, unsigned char prec, char *s);
+
+// ---------------------------------------------------------------------------
+// 3: STRING
+// ---------------------------------------------------------------------------
+class String
+{
+  public:
+    String(void) { }
+    String(const char *s) : str(s ? s : "") { }
+    String(char *s) : str(s ? s : "") { }
+    String(const std::string &s) : str(s) { }
+    String(const String &s) : str(s.str) { }
+    explicit String(char c) : str(1, c) { }
+    explicit String(unsigned char val, unsigned char base = 10);
+    explicit String(int val, unsigned char base = 10);
+    explicit String(unsigned int val, unsigned char base = 10);
+    explicit String(long val, unsigned char base = 10);
+    explicit String(unsigned long val, unsigned char base = 10);
+    explicit String(float val, unsigned char decimals = 2);
+    explicit String(double val, unsigned char decimals = 2);
+
+    String &operator=(const String &s)  { str = s.str; return *this; }
+    String &operator=(const char *s)    { str = s ? s : ""; return *this; }
+
+    String &operator+=(const String &s) { str += s.str; return *this; }
+    String &operator+=(const char *s)   { str += s; return *this; }
+    String &operator+=(char c)          { str += c; return *this; }
+    String &operator+=(int val)         { return *this += String(val); }
+    String &operator+=(unsigned int val)  { return *this += String(val); }
+    String &operator+=(long val)        { return *this += String(val); }
+    String &operator+=(unsigned long val) { return *this += String(val); }
+    String &operator+=(float val)       { return *this += String(val); }
+    String &operator+=(double val)      { return *this += String(val); }
+    bool concat(const String &s)        { str += s.str; return true; }
+
+    bool operator==(const String &s) const { return str == s.str; }
+    bool operator==(const char *s) const   { return str == (s ? s : ""); }
+    bool operator!=(const String &s) const { return str != s.str; }
+    bool operator!=(const char *s) const   { return !(*this == s); }
+    bool operator<(const String &s) const  { return str < s.str; }
+    bool equals(const String &s) const     { return str == s.str; }
+    bool equalsIgnoreCase(const String &s) const;
+
+    char operator[](unsigned int i) const  { return (i < str.size()) ? str[i] : 0; }
+    char &operator[](unsigned int i)       { return str[i]; }
+    char charAt(unsigned int i) const      { return (*this)[i]; }
+    void setCharAt(unsigned int i, char c) { if ( i < str.size() ) str[i] = c; }
+
+    unsigned int length(void) const        { return str.size(); }
+    bool isEmpty(void) const               { return str.empty(); }
+    const char *c_str(void) const          { return str.c_str(); }
+    bool reserve(unsigned int size)        { str.reserve(size); return true; }
+
+    String substring(unsigned int from) const;
+    String substring(unsigned int from, unsigned int to) const;
+    int  indexOf(char c, unsigned int from = 0) const;
+    int  indexOf(const String &s, unsigned int from = 0) const;
+    int  lastIndexOf(char c) const;
+    bool startsWith(const String &s) const { return str.compare(0, s.str.size(), s.str) == 0; }
+    bool endsWith(const String &s) const;
+    void replace(const String &from, const String &to);
+    void remove(unsigned int index, unsigned int count = (unsigned int) -1);
+    void trim(void);
+    void toUpperCase(void);
+    void toLowerCase(void);
+    long  toInt(void) const                { return atol(str.c_str()); }
+    float toFloat(void) const              { return (float) atof(str.c_str()); }
+    double toDouble(void) const            { return atof(str.c_str()); }
+    void toCharArray(char *buf, unsigned int size, unsigned int index = 0) const;
+    void getBytes(unsigned char *buf, unsigned int size, unsigned int index = 0) const;
+
+    std::string str;
+};
+
+String operator+(const String &a, const String &b);
+String operator+(const String &a, const char *b);
+String operator+(const char *a, const String &b);
+String operator+(const String &a, char b);
+String operator+(const String &a, int b);
+String operator+(const String &a, unsigned int b);
+String operator+(const String &a, long b);
+String operator+(const String &a, unsigned long b);
+String operator+(const String &a, float b);
+String operator+(const String &a, double b);
+
+// ---------------------------------------------------------------------------
+// 4: IPADDRESS
+// ---------------------------------------------------------------------------
+class IPAddress
+{
+  public:
+    IPAddress(void) : addr { 0, 0, 0, 0 } { }
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : addr { a, b, c, d } { }
+    uint8_t operator[](int i) const        { return addr[i]; }
+    uint8_t &operator[](int i)             { return addr[i]; }
+    String toString(void) const;
+  private:
+    uint8_t addr[4];
+};
+
+// ---------------------------------------------------------------------------
+// 5: SERIAL PORT
+// ---------------------------------------------------------------------------
+// output is collected for the test to read, simserialin() queues input
+class HardwareSerial
+{
+  public:
+    void begin(unsigned long) { }
+    void end(void) { }
+    void flush(void) { }
+    int  available(void);
+    int  read(void);
+    int  peek(void);
+    String readStringUntil(char terminator);
+    size_t write(uint8_t c);
+    size_t write(const uint8_t *data, size_t len);
+    size_t write(const char *s)            { return write((const uint8_t *) s, strlen(s)); }
+    size_t print(const String &s)          { return write((const uint8_t *) s.c_str(), s.length()); }
+    size_t print(const char *s)            { return write(s); }
+    size_t print(char c)                   { return write((uint8_t) c); }
+    size_t print(unsigned char val, int base = 10)  { return print(String(val, base)); }
+    size_t print(int val, int base = 10)            { return print(String(val, base)); }
+    size_t print(unsigned int val, int base = 10)   { return print(String(val, base)); }
+    size_t print(long val, int base = 10)           { return print(String(val, base)); }
+    size_t print(unsigned long val, int base = 10)  { return print(String(val, base)); }
+    size_t print(double val, int decimals = 2)      { return print(String(val, decimals)); }
+    size_t print(const IPAddress &ip)               { return print(ip.toString()); }
+    template <typename T> size_t println(const T &val)  { size_t n = print(val); return n + print("\r\n"); }
+    size_t println(double val, int decimals)        { size_t n = print(val, decimals); return n + print("\r\n"); }
+    size_t println(void)                   { return print("\r\n"); }
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+    operator bool(void) const              { return true; }
+};
+
+extern HardwareSerial Serial;
+
+// ---------------------------------------------------------------------------
+// 6: ESP
+// ---------------------------------------------------------------------------
+class EspClass
+{
+  public:
+    uint32_t getFreeHeap(void)             { return 40000; }
+    uint8_t  getCpuFreqMHz(void)           { return 80; }
+    uint32_t getChipId(void)               { return 0x00F2E5; }
+    void     restart(void);                 // counted by the simulation, see simrestarts()
+};
+
+extern EspClass ESP;
+
+#endif
@@ -0,0 +1,106 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP HOST BUILD - JSON DOCUMENT
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+// The part of ArduinoJson 6 that SetupData uses to import and export the settings: objects, arrays,
+// numbers and strings, read and written by key or index. The capacity given to the document is
+// ignored, a missing key reads as 0 or an empty string.
+
+#ifndef ArduinoJson_h
+#define ArduinoJson_h
+
+#include <Arduino.h>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#define JSON_OBJECT_SIZE(n)   ((n) * 16)
+#define JSON_ARRAY_SIZE(n)    ((n) * 8)
+
+struct JsonNode
+{
+  enum { JNULL, JNUMBER, JSTRING, JBOOL, JARRAY, JOBJECT } type = JNULL;
+  double number = 0;
+  std::string text;
+  std::vector<JsonNode> items;
+  std::vector<std::pair<std::string, JsonNode>> members;
+};
+
+class JsonVariant
+{
+  public:
+    explicit JsonVariant(JsonNode *n) : node(n) { }
+
+    JsonVariant operator[](const char *key);
+    JsonVariant operator[](const String &key)  { return (*this)[key.c_str()]; }
+    JsonVariant operator[](int index);
+
+    template <typename T, typename std::enable_if<std::is_arithmetic<T>::value, int>::type = 0>
+    JsonVariant &operator=(T val)
+    {
+      node->type = std::is_same<T, bool>::value ? JsonNode::JBOOL : JsonNode::JNUMBER;
+      node->number = (double) val;
+      return *this;
+    }
+    JsonVariant &operator=(const char *s)      { node->type = JsonNode::JSTRING; node->text = s ? s : ""; return *this; }
+    JsonVariant &operator=(const String &s)    { return *this = s.c_str(); }
+
+    template <typename T, typename std::enable_if<std::is_arithmetic<T>::value, int>::type = 0>
+    operator T(void) const
+    {
+      if ( node->type == JsonNode::JSTRING )
+      {
+        return (T) atof(node->text.c_str());
+      }
+      return (T) node->number;
+    }
+
+    template <typename T> T as(void) const;
+    bool isNull(void) const                    { return node->type == JsonNode::JNULL; }
+
+  private:
+    JsonNode *node;
+};
+
+template <> inline const char *JsonVariant::as<const char *>(void) const
+{
+  return (node->type == JsonNode::JSTRING) ? node->text.c_str() : "";
+}
+
+template <> inline char *JsonVariant::as<char *>(void) const
+{
+  return (char *) as<const char *>();
+}
+
+class DynamicJsonDocument
+{
+  public:
+    explicit DynamicJsonDocument(size_t) { root.type = JsonNode::JOBJECT; }
+    JsonVariant operator[](const char *key)    { return JsonVariant(&root)[key]; }
+    JsonVariant operator[](const String &key)  { return JsonVariant(&root)[key]; }
+    void clear(void)                           { root = JsonNode(); root.type = JsonNode::JOBJECT; }
+    JsonNode root;
+};
+
+class DeserializationError
+{
+  public:
+    explicit DeserializationError(bool e) : error(e) { }
+    operator bool(void) const                  { return error; }
+    const char *c_str(void) const              { return error ? "InvalidInput" : "Ok"; }
+  private:
+    bool error;
+};
+
+DeserializationError deserializeJson(DynamicJsonDocument &doc, const String &input);
+DeserializationError deserializeJson(DynamicJsonDocument &doc, const char *input);
+size_t serializeJson(const DynamicJsonDocument &doc, String &output);
+
+#endif
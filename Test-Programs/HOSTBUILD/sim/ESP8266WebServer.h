@@ -0,0 +1,30 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP HOST BUILD - SIMULATED HTTP SERVER
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+// the management, web and ascom servers are not part of the host build, this is only the type
+
+#ifndef ESP8266WebServer_h
+#define ESP8266WebServer_h
+
+#include <Arduino.h>
+
+class ESP8266WebServer
+{
+  public:
+    explicit ESP8266WebServer(int p = 80) : port(p) { }
+    void begin(void) { }
+    void stop(void) { }
+    void close(void) { }
+    void handleClient(void) { }
+    int port;
+};
+
+#endif
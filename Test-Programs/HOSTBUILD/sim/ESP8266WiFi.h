@@ -0,0 +1,41 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP HOST BUILD - SIMULATED WIFI
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+// the station is always connected, with a fixed address
+
+#ifndef ESP8266WiFi_h
+#define ESP8266WiFi_h
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+#include <WiFiServer.h>
+
+#define WL_CONNECTED          3
+#define WL_DISCONNECTED       6
+#define WIFI_STA              1
+#define WIFI_AP               2
+
+class ESP8266WiFiClass
+{
+  public:
+    void mode(int) { }
+    void begin(const char *, const char *) { }
+    void config(IPAddress, IPAddress, IPAddress, IPAddress) { }
+    bool softAP(const char *, const char *)  { return true; }
+    int  status(void)                        { return WL_CONNECTED; }
+    IPAddress localIP(void)                  { return IPAddress(127, 0, 0, 1); }
+    long RSSI(void)                          { return -50; }
+    const char *getHostname(void)            { return "myfp2esp"; }
+};
+
+extern ESP8266WiFiClass WiFi;
+
+#endif
@@ -0,0 +1,66 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP HOST BUILD - SIMULATED FILE SYSTEM
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+// SPIFFS held in memory, simfiles() gives a test the contents so it can check or damage them
+
+#ifndef FS_h
+#define FS_h
+
+#include <Arduino.h>
+#include <map>
+#include <memory>
+
+typedef std::map<std::string, std::shared_ptr<std::string>> simfiles_t;
+
+class File
+{
+  public:
+    File(void) { }
+    File(const std::string &n, const std::shared_ptr<std::string> &d, size_t pos) : filename(n), data(d), position(pos) { }
+    operator bool(void) const              { return (bool) data; }
+    int  available(void)                   { return data ? (int) (data->size() - position) : 0; }
+    int  read(void);
+    size_t read(uint8_t *buf, size_t size);
+    size_t write(uint8_t c)                { return write(&c, 1); }
+    size_t write(const uint8_t *buf, size_t size);
+    size_t print(const String &s)          { return write((const uint8_t *) s.c_str(), s.length()); }
+    size_t print(const char *s)            { return write((const uint8_t *) s, strlen(s)); }
+    String readString(void);
+    bool   seek(uint32_t pos);
+    size_t size(void) const                { return data ? data->size() : 0; }
+    size_t pos(void) const                 { return position; }
+    const char *name(void) const           { return filename.c_str(); }
+    bool isDirectory(void) const           { return false; }
+    File openNextFile(void)                { return File(); }
+    void flush(void) { }
+    void close(void)                       { data.reset(); }
+  private:
+    std::string filename;
+    std::shared_ptr<std::string> data;
+    size_t position = 0;
+};
+
+class FS
+{
+  public:
+    bool begin(void)                       { return true; }
+    bool format(void)                      { files.clear(); return true; }
+    void end(void) { }
+    File open(const String &path, const char *mode = "r");
+    bool exists(const String &path)        { return files.count(path.str) != 0; }
+    bool remove(const String &path)        { return files.erase(path.str) != 0; }
+    bool rename(const String &from, const String &to);
+    simfiles_t files;
+};
+
+extern FS SPIFFS;
+
+#endif
@@ -0,0 +1,24 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP HOST BUILD - SIMULATED ONEWIRE
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+#ifndef OneWire_h
+#define OneWire_h
+
+#include <Arduino.h>
+
+class OneWire
+{
+  public:
+    explicit OneWire(uint8_t p) : pin(p) { }
+    uint8_t pin;
+};
+
+#endif
@@ -0,0 +1,21 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP HOST BUILD - SIMULATED SSD1306 DRIVER
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+// the displays are not part of the host build, the classes in displays.h only need the names
+
+#ifndef SSD1306Wire_h
+#define SSD1306Wire_h
+
+class SSD1306Wire
+{
+};
+
+#endif
@@ -0,0 +1,55 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP HOST BUILD - SIMULATED TCP CLIENT
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+// A connection is a pair of byte queues shared by the firmware's WiFiClient and the test's SimClient,
+// see simconnect() in hostsim.h
+
+#ifndef WiFiClient_h
+#define WiFiClient_h
+
+#include <Arduino.h>
+#include <deque>
+#include <memory>
+
+struct simconnection_t
+{
+  std::deque<uint8_t> rx;                       // test to firmware
+  std::string tx;                               // firmware to test
+  bool open = true;
+  unsigned long writes = 0;                     // write() calls made by the firmware
+};
+
+class WiFiClient
+{
+  public:
+    WiFiClient(void) { }
+    explicit WiFiClient(const std::shared_ptr<simconnection_t> &c) : conn(c) { }
+    uint8_t connected(void)                { return conn && (conn->open || !conn->rx.empty()); }
+    int  available(void)                   { return conn ? (int) conn->rx.size() : 0; }
+    int  read(void);
+    int  read(uint8_t *buf, size_t size);
+    int  peek(void)                        { return available() ? conn->rx.front() : -1; }
+    size_t write(uint8_t c)                { return write(&c, 1); }
+    size_t write(const uint8_t *buf, size_t size);
+    size_t write(const char *s)            { return write((const uint8_t *) s, strlen(s)); }
+    size_t print(const String &s)          { return write((const uint8_t *) s.c_str(), s.length()); }
+    size_t print(const char *s)            { return write(s); }
+    size_t println(const String &s)        { return print(s) + write("\r\n"); }
+    void flush(void) { }
+    void setNoDelay(bool) { }
+    void stop(void);
+    IPAddress remoteIP(void)               { return IPAddress(127, 0, 0, 1); }
+    operator bool(void)                    { return available() || connected(); }
+  private:
+    std::shared_ptr<simconnection_t> conn;
+};
+
+#endif
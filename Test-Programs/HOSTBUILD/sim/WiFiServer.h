@@ -0,0 +1,32 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP HOST BUILD - SIMULATED TCP SERVER
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+#ifndef WiFiServer_h
+#define WiFiServer_h
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+
+class WiFiServer
+{
+  public:
+    explicit WiFiServer(uint16_t p) : port(p) { }
+    void begin(void)                       { listening = true; }
+    void begin(uint16_t p)                 { port = p; listening = true; }
+    void stop(void)                        { listening = false; }
+    void close(void)                       { listening = false; }
+    void setNoDelay(bool) { }
+    WiFiClient available(void);             // next connection queued by simconnect()
+    uint16_t port;
+    bool listening = false;
+};
+
+#endif
@@ -0,0 +1,100 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP HOST BUILD - DISPLAY AND SERVER STUBS
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+// displays.cpp, webserver.cpp, Ascom.cpp and ManagementServer.cpp are not part of the host build.
+// The focuser core only switches these services on and off, so that is all they do here.
+
+#include <Arduino.h>
+#include "hal.h"
+#include "generalDefinitions.h"
+#include "focuserconfig.h"
+#include "FocuserSetupData.h"
+#include "displays.h"
+
+extern SetupData *mySetupData;
+extern bool webserverstate;
+extern bool ascomserverstate;
+extern bool ascomdiscoverystate;
+extern bool managementserverstate;
+
+halhttpserver_t *webserver = nullptr;
+halhttpserver_t *ascomserver = nullptr;
+halhttpserver_t mserver(MSSERVERPORT);
+String MSpg;
+
+bool CheckOledConnected(void)
+{
+  return false;
+}
+
+OLED_NON::OLED_NON() {}
+void OLED_NON::oledgraphicmsg(String &, int, bool) {}
+void OLED_NON::oled_draw_Wifi(int) {}
+void OLED_NON::oledtextmsg(String, int, boolean, boolean) {}
+void OLED_NON::update_oledtext_position(void) {}
+void OLED_NON::update_oledtextdisplay(void) {}
+void OLED_NON::Update_Oled(const oled_state, const connection_status) {}
+void OLED_NON::oled_draw_reboot(void) {}
+
+void start_webserver(void)
+{
+  if ( webserver == nullptr )
+  {
+    webserver = new halhttpserver_t(mySetupData->get_webserverport());
+  }
+  webserverstate = RUNNING;
+}
+
+void stop_webserver(void)
+{
+  if ( mySetupData->get_webserverstate() == 1)
+  {
+    delete webserver;
+    webserver = nullptr;
+    mySetupData->set_webserverstate(0);
+  }
+  webserverstate = STOPPED;
+}
+
+void start_ascomremoteserver(void)
+{
+  if ( ascomserver == nullptr )
+  {
+    ascomserver = new halhttpserver_t(mySetupData->get_ascomalpacaport());
+  }
+  ascomserverstate = RUNNING;
+  ascomdiscoverystate = RUNNING;
+}
+
+void stop_ascomremoteserver(void)
+{
+  if ( ascomserverstate == RUNNING )
+  {
+    delete ascomserver;
+    ascomserver = nullptr;
+  }
+  ascomserverstate = STOPPED;
+  ascomdiscoverystate = STOPPED;
+}
+
+void checkASCOMALPACADiscovery(void)
+{
+}
+
+void start_management(void)
+{
+  managementserverstate = RUNNING;
+}
+
+void stop_management(void)
+{
+  managementserverstate = STOPPED;
+}
@@ -0,0 +1,893 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP HOST BUILD - SIMULATED PERIPHERALS
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+#include <stdarg.h>
+#include <deque>
+#include "hostsim.h"
+#include <ArduinoJson.h>
+#include <myDallasTemperature.h>
+
+extern void setup(void);
+extern void loop(void);
+
+HardwareSerial Serial;
+EspClass ESP;
+ESP8266WiFiClass WiFi;
+FS SPIFFS;
+
+// ---------------------------------------------------------------------------
+// 1: TIME AND TIMER
+// ---------------------------------------------------------------------------
+static uint64_t simnow = 0;                     // simulated time in uS
+static void (*timerisr)(void) = nullptr;
+static unsigned long timerperiod = 0;
+static uint64_t timernext = 0;
+static bool timerarmed = false;
+
+void simadvance(unsigned long us)
+{
+  uint64_t target = simnow + us;
+  while ( timerarmed && (timernext <= target) )
+  {
+    simnow = timernext;
+    timernext += timerperiod;
+    timerisr();                                 // may rearm with a new period or stop the timer
+  }
+  simnow = target;
+}
+
+void simsettimer(void (*isr)(void), unsigned long periodus)
+{
+  timerisr = isr;
+  timerperiod = (periodus == 0) ? 1 : periodus;
+  timernext = simnow + timerperiod;
+  timerarmed = true;
+}
+
+void simsetperiod(unsigned long periodus)
+{
+  timerperiod = (periodus == 0) ? 1 : periodus;
+  timernext = simnow + timerperiod;
+}
+
+void simstoptimer(void)
+{
+  timerarmed = false;
+}
+
+bool simtimerarmed(void)
+{
+  return timerarmed;
+}
+
+void simsetup(void)
+{
+  setup();
+}
+
+void simrun(unsigned long ms, unsigned long looppassus)
+{
+  uint64_t end = simnow + (uint64_t) ms * 1000;
+  while ( simnow < end )
+  {
+    loop();
+    simadvance(looppassus);
+  }
+}
+
+unsigned long millis(void)
+{
+  return (unsigned long) (simnow / 1000);
+}
+
+unsigned long micros(void)
+{
+  return (unsigned long) simnow;
+}
+
+void delay(unsigned long ms)
+{
+  simadvance(ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  simadvance(us);
+}
+
+void yield(void)
+{
+}
+
+// ---------------------------------------------------------------------------
+// 2: GPIO
+// ---------------------------------------------------------------------------
+static int pinlevel[256];
+static bool pinlevelset = false;
+static void (*pinisr[256])(void);
+
+static void initpins(void)
+{
+  if ( !pinlevelset )
+  {
+    for ( int i = 0; i < 256; i++ )
+    {
+      pinlevel[i] = HIGH;                       // inputs read as pulled up until driven
+    }
+    pinlevelset = true;
+  }
+}
+
+void pinMode(uint8_t, uint8_t)
+{
+  initpins();
+}
+
+int digitalRead(uint8_t pin)
+{
+  initpins();
+  return pinlevel[pin];
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+  initpins();
+  pinlevel[pin] = val ? HIGH : LOW;
+}
+
+int analogRead(uint8_t)
+{
+  return 512;
+}
+
+void attachInterrupt(uint8_t pin, void (*isr)(void), int)
+{
+  pinisr[pin] = isr;
+}
+
+void detachInterrupt(uint8_t pin)
+{
+  pinisr[pin] = nullptr;
+}
+
+void simsetpin(uint8_t pin, int level)
+{
+  initpins();
+  level = level ? HIGH : LOW;
+  if ( pinlevel[pin] != level )
+  {
+    pinlevel[pin] = level;
+    if ( pinisr[pin] )
+    {
+      pinisr[pin]();
+    }
+  }
+}
+
+int simgetpin(uint8_t pin)
+{
+  return digitalRead(pin);
+}
+
+// ---------------------------------------------------------------------------
+// 3: NUMBER CONVERSIONS
+// ---------------------------------------------------------------------------
+char *ultoa(unsigned long val, char *s, int radix)
+{
+  char tmp[sizeof(unsigned long) * 8 + 1];
+  int i = 0;
+  do
+  {
+    int d = val % radix;
+    tmp[i++] = (d < 10) ? ('0' + d) : ('a' + d - 10);
+    val /= radix;
+  } while ( val );
+  for ( int j = 0; j < i; j++ )
+  {
+    s[j] = tmp[i - 1 - j];
+  }
+  s[i] = 0;
+  return s;
+}
+
+char *ltoa(long val, char *s, int radix)
+{
+  if ( (val < 0) && (radix == 10) )
+  {
+    s[0] = '-';
+    ultoa(0UL - (unsigned long) val, s + 1, radix);
+    return s;
+  }
+  return ultoa((unsigned long) val, s, radix);
+}
+
+char *itoa(int val, char *s, int radix)
+{
+  return ltoa(val, s, radix);
+}
+
+char *dtostrf(double val, signed char width, unsigned char prec, char *s)
+{
+  sprintf(s, "%*.*f", width, prec, val);
+  return s;
+}
+
+// ---------------------------------------------------------------------------
+// 4: STRING
+// ---------------------------------------------------------------------------
+static std::string numstr(unsigned long val, bool negative, unsigned char base)
+{
+  char buf[sizeof(unsigned long) * 8 + 2];
+  ultoa(val, buf, base);
+  return negative ? (std::string("-") + buf) : std::string(buf);
+}
+
+String::String(unsigned char val, unsigned char base) : str(numstr(val, false, base)) { }
+String::String(unsigned int val, unsigned char base) : str(numstr(val, false, base)) { }
+String::String(unsigned long val, unsigned char base) : str(numstr(val, false, base)) { }
+String::String(int val, unsigned char base) : String((long) val, base) { }
+
+String::String(long val, unsigned char base)
+{
+  bool negative = (val < 0) && (base == 10);
+  str = numstr(negative ? (0UL - (unsigned long) val) : (unsigned long) val, negative, base);
+}
+
+String::String(float val, unsigned char decimals) : String((double) val, decimals) { }
+
+String::String(double val, unsigned char decimals)
+{
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%.*f", decimals, val);
+  str = buf;
+}
+
+bool String::equalsIgnoreCase(const String &s) const
+{
+  return strcasecmp(str.c_str(), s.str.c_str()) == 0;
+}
+
+String String::substring(unsigned int from) const
+{
+  return (from < str.size()) ? String(str.substr(from)) : String();
+}
+
+String String::substring(unsigned int from, unsigned int to) const
+{
+  if ( from > to )
+  {
+    unsigned int t = from;
+    from = to;
+    to = t;
+  }
+  if ( from >= str.size() )
+  {
+    return String();
+  }
+  return String(str.substr(from, to - from));
+}
+
+int String::indexOf(char c, unsigned int from) const
+{
+  size_t i = str.find(c, from);
+  return (i == std::string::npos) ? -1 : (int) i;
+}
+
+int String::indexOf(const String &s, unsigned int from) const
+{
+  size_t i = str.find(s.str, from);
+  return (i == std::string::npos) ? -1 : (int) i;
+}
+
+int String::lastIndexOf(char c) const
+{
+  size_t i = str.rfind(c);
+  return (i == std::string::npos) ? -1 : (int) i;
+}
+
+bool String::endsWith(const String &s) const
+{
+  return (str.size() >= s.str.size()) && (str.compare(str.size() - s.str.size(), s.str.size(), s.str) == 0);
+}
+
+void String::replace(const String &from, const String &to)
+{
+  if ( from.str.empty() )
+  {
+    return;
+  }
+  size_t i = 0;
+  while ( (i = str.find(from.str, i)) != std::string::npos )
+  {
+    str.replace(i, from.str.size(), to.str);
+    i += to.str.size();
+  }
+}
+
+void String::remove(unsigned int index, unsigned int count)
+{
+  if ( index < str.size() )
+  {
+    str.erase(index, count);
+  }
+}
+
+void String::trim(void)
+{
+  size_t first = str.find_first_not_of(" \t\r\n");
+  size_t last = str.find_last_not_of(" \t\r\n");
+  str = (first == std::string::npos) ? std::string() : str.substr(first, last - first + 1);
+}
+
+void String::toUpperCase(void)
+{
+  for ( char &c : str )
+  {
+    c = toupper(c);
+  }
+}
+
+void String::toLowerCase(void)
+{
+  for ( char &c : str )
+  {
+    c = tolower(c);
+  }
+}
+
+void String::toCharArray(char *buf, unsigned int size, unsigned int index) const
+{
+  getBytes((unsigned char *) buf, size, index);
+}
+
+void String::getBytes(unsigned char *buf, unsigned int size, unsigned int index) const
+{
+  if ( size == 0 )
+  {
+    return;
+  }
+  unsigned int n = 0;
+  if ( index < str.size() )
+  {
+    n = str.size() - index;
+    n = (n < size - 1) ? n : size - 1;
+    memcpy(buf, str.data() + index, n);
+  }
+  buf[n] = 0;
+}
+
+String operator+(const String &a, const String &b)    { String s(a); s += b; return s; }
+String operator+(const String &a, const char *b)      { String s(a); s += b; return s; }
+String operator+(const char *a, const String &b)      { String s(a); s += b; return s; }
+String operator+(const String &a, char b)             { String s(a); s += b; return s; }
+String operator+(const String &a, int b)              { String s(a); s += b; return s; }
+String operator+(const String &a, unsigned int b)     { String s(a); s += b; return s; }
+String operator+(const String &a, long b)             { String s(a); s += b; return s; }
+String operator+(const String &a, unsigned long b)    { String s(a); s += b; return s; }
+String operator+(const String &a, float b)            { String s(a); s += b; return s; }
+String operator+(const String &a, double b)           { String s(a); s += b; return s; }
+
+String IPAddress::toString(void) const
+{
+  char buf[16];
+  snprintf(buf, sizeof(buf), "%u.%u.%u.%u", addr[0], addr[1], addr[2], addr[3]);
+  return String(buf);
+}
+
+// ---------------------------------------------------------------------------
+// 5: SERIAL PORT AND ESP
+// ---------------------------------------------------------------------------
+static std::deque<char> serialrx;
+static std::string serialtx;
+static unsigned long restarts = 0;
+
+int HardwareSerial::available(void)
+{
+  return (int) serialrx.size();
+}
+
+int HardwareSerial::read(void)
+{
+  if ( serialrx.empty() )
+  {
+    return -1;
+  }
+  char c = serialrx.front();
+  serialrx.pop_front();
+  return (uint8_t) c;
+}
+
+int HardwareSerial::peek(void)
+{
+  return serialrx.empty() ? -1 : (uint8_t) serialrx.front();
+}
+
+String HardwareSerial::readStringUntil(char terminator)
+{
+  String s;
+  int c;
+  while ( ((c = read()) != -1) && (c != terminator) )
+  {
+    s += (char) c;
+  }
+  return s;
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+  serialtx += (char) c;
+  return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t *data, size_t len)
+{
+  serialtx.append((const char *) data, len);
+  return len;
+}
+
+size_t HardwareSerial::printf(const char *format, ...)
+{
+  char buf[256];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+  return write(buf);
+}
+
+void simserialin(const std::string &s)
+{
+  serialrx.insert(serialrx.end(), s.begin(), s.end());
+}
+
+std::string simserialout(void)
+{
+  std::string s;
+  s.swap(serialtx);
+  return s;
+}
+
+void EspClass::restart(void)
+{
+  restarts++;
+}
+
+unsigned long simrestarts(void)
+{
+  return restarts;
+}
+
+// ---------------------------------------------------------------------------
+// 6: TCP CONNECTIONS
+// ---------------------------------------------------------------------------
+static std::deque<std::shared_ptr<simconnection_t>> pending;
+
+SimClient simconnect(void)
+{
+  std::shared_ptr<simconnection_t> c = std::make_shared<simconnection_t>();
+  pending.push_back(c);
+  return SimClient(c);
+}
+
+WiFiClient WiFiServer::available(void)
+{
+  if ( !listening || pending.empty() )
+  {
+    return WiFiClient();
+  }
+  std::shared_ptr<simconnection_t> c = pending.front();
+  pending.pop_front();
+  return WiFiClient(c);
+}
+
+int WiFiClient::read(void)
+{
+  uint8_t c;
+  return (read(&c, 1) == 1) ? c : -1;
+}
+
+int WiFiClient::read(uint8_t *buf, size_t size)
+{
+  size_t n = 0;
+  while ( conn && (n < size) && !conn->rx.empty() )
+  {
+    buf[n++] = conn->rx.front();
+    conn->rx.pop_front();
+  }
+  return (int) n;
+}
+
+size_t WiFiClient::write(const uint8_t *buf, size_t size)
+{
+  if ( !conn || !conn->open )
+  {
+    return 0;
+  }
+  conn->tx.append((const char *) buf, size);
+  conn->writes++;
+  return size;
+}
+
+void WiFiClient::stop(void)
+{
+  if ( conn )
+  {
+    conn->open = false;
+    conn.reset();
+  }
+}
+
+// ---------------------------------------------------------------------------
+// 7: FILE SYSTEM
+// ---------------------------------------------------------------------------
+simfiles_t &simfiles(void)
+{
+  return SPIFFS.files;
+}
+
+void simformat(void)
+{
+  SPIFFS.files.clear();
+}
+
+File FS::open(const String &path, const char *mode)
+{
+  simfiles_t::iterator f = files.find(path.str);
+  if ( mode[0] == 'r' )
+  {
+    return (f == files.end()) ? File() : File(path.str, f->second, 0);
+  }
+  if ( (f == files.end()) || (mode[0] == 'w') )
+  {
+    files[path.str] = std::make_shared<std::string>();
+  }
+  std::shared_ptr<std::string> data = files[path.str];
+  return File(path.str, data, (mode[0] == 'a') ? data->size() : 0);
+}
+
+bool FS::rename(const String &from, const String &to)
+{
+  simfiles_t::iterator f = files.find(from.str);
+  if ( f == files.end() )
+  {
+    return false;
+  }
+  std::shared_ptr<std::string> data = f->second;
+  files.erase(f);
+  files[to.str] = data;
+  return true;
+}
+
+int File::read(void)
+{
+  uint8_t c;
+  return (read(&c, 1) == 1) ? c : -1;
+}
+
+size_t File::read(uint8_t *buf, size_t size)
+{
+  if ( !data || (position >= data->size()) )
+  {
+    return 0;
+  }
+  size_t n = data->size() - position;
+  n = (n < size) ? n : size;
+  memcpy(buf, data->data() + position, n);
+  position += n;
+  return n;
+}
+
+size_t File::write(const uint8_t *buf, size_t size)
+{
+  if ( !data )
+  {
+    return 0;
+  }
+  if ( position > data->size() )
+  {
+    position = data->size();
+  }
+  data->replace(position, size, (const char *) buf, size);
+  position += size;
+  return size;
+}
+
+String File::readString(void)
+{
+  String s;
+  if ( data && (position < data->size()) )
+  {
+    s = String(data->substr(position));
+    position = data->size();
+  }
+  return s;
+}
+
+bool File::seek(uint32_t pos)
+{
+  if ( !data || (pos > data->size()) )
+  {
+    return false;
+  }
+  position = pos;
+  return true;
+}
+
+// ---------------------------------------------------------------------------
+// 8: JSON
+// ---------------------------------------------------------------------------
+JsonVariant JsonVariant::operator[](const char *key)
+{
+  if ( node->type != JsonNode::JOBJECT )
+  {
+    *node = JsonNode();
+    node->type = JsonNode::JOBJECT;
+  }
+  for ( auto &m : node->members )
+  {
+    if ( m.first == key )
+    {
+      return JsonVariant(&m.second);
+    }
+  }
+  node->members.push_back(std::make_pair(std::string(key), JsonNode()));
+  return JsonVariant(&node->members.back().second);
+}
+
+JsonVariant JsonVariant::operator[](int index)
+{
+  if ( node->type != JsonNode::JARRAY )
+  {
+    *node = JsonNode();
+    node->type = JsonNode::JARRAY;
+  }
+  if ( (size_t) index >= node->items.size() )
+  {
+    node->items.resize(index + 1);
+  }
+  return JsonVariant(&node->items[index]);
+}
+
+static void writejson(const JsonNode &n, std::string &out)
+{
+  char buf[32];
+  switch ( n.type )
+  {
+    case JsonNode::JNUMBER:
+      if ( (n.number == (double) (long long) n.number) && (fabs(n.number) < 1e15) )
+      {
+        snprintf(buf, sizeof(buf), "%lld", (long long) n.number);
+      }
+      else
+      {
+        snprintf(buf, sizeof(buf), "%.9g", n.number);
+      }
+      out += buf;
+      break;
+    case JsonNode::JBOOL:
+      out += n.number ? "true" : "false";
+      break;
+    case JsonNode::JSTRING:
+      out += '"';
+      for ( char c : n.text )
+      {
+        if ( (c == '"') || (c == '\\') )
+        {
+          out += '\\';
+        }
+        out += c;
+      }
+      out += '"';
+      break;
+    case JsonNode::JARRAY:
+      out += '[';
+      for ( size_t i = 0; i < n.items.size(); i++ )
+      {
+        out += i ? "," : "";
+        writejson(n.items[i], out);
+      }
+      out += ']';
+      break;
+    case JsonNode::JOBJECT:
+      out += '{';
+      for ( size_t i = 0; i < n.members.size(); i++ )
+      {
+        out += i ? ",\"" : "\"";
+        out += n.members[i].first;
+        out += "\":";
+        writejson(n.members[i].second, out);
+      }
+      out += '}';
+      break;
+    default:
+      out += "null";
+      break;
+  }
+}
+
+size_t serializeJson(const DynamicJsonDocument &doc, String &output)
+{
+  output.str.clear();
+  writejson(doc.root, output.str);
+  return output.length();
+}
+
+static void skipspace(const char *&p)
+{
+  while ( isspace((unsigned char) *p) )
+  {
+    p++;
+  }
+}
+
+static bool readjson(const char *&p, JsonNode &n)
+{
+  skipspace(p);
+  n = JsonNode();
+  if ( *p == '{' )
+  {
+    n.type = JsonNode::JOBJECT;
+    p++;
+    skipspace(p);
+    if ( *p == '}' )
+    {
+      p++;
+      return true;
+    }
+    for ( ;; )
+    {
+      JsonNode key;
+      if ( !readjson(p, key) || (key.type != JsonNode::JSTRING) )
+      {
+        return false;
+      }
+      skipspace(p);
+      if ( *p++ != ':' )
+      {
+        return false;
+      }
+      n.members.push_back(std::make_pair(key.text, JsonNode()));
+      if ( !readjson(p, n.members.back().second) )
+      {
+        return false;
+      }
+      skipspace(p);
+      if ( *p == '}' )
+      {
+        p++;
+        return true;
+      }
+      if ( *p++ != ',' )
+      {
+        return false;
+      }
+    }
+  }
+  if ( *p == '[' )
+  {
+    n.type = JsonNode::JARRAY;
+    p++;
+    skipspace(p);
+    if ( *p == ']' )
+    {
+      p++;
+      return true;
+    }
+    for ( ;; )
+    {
+      n.items.push_back(JsonNode());
+      if ( !readjson(p, n.items.back()) )
+      {
+        return false;
+      }
+      skipspace(p);
+      if ( *p == ']' )
+      {
+        p++;
+        return true;
+      }
+      if ( *p++ != ',' )
+      {
+        return false;
+      }
+    }
+  }
+  if ( *p == '"' )
+  {
+    n.type = JsonNode::JSTRING;
+    p++;
+    while ( *p && (*p != '"') )
+    {
+      if ( (*p == '\\') && p[1] )
+      {
+        p++;
+      }
+      n.text += *p++;
+    }
+    return *p++ == '"';
+  }
+  if ( !strncmp(p, "true", 4) || !strncmp(p, "false", 5) )
+  {
+    n.type = JsonNode::JBOOL;
+    n.number = (*p == 't');
+    p += (*p == 't') ? 4 : 5;
+    return true;
+  }
+  if ( !strncmp(p, "null", 4) )
+  {
+    p += 4;
+    return true;
+  }
+  char *end;
+  n.number = strtod(p, &end);
+  if ( end == p )
+  {
+    return false;
+  }
+  n.type = JsonNode::JNUMBER;
+  p = end;
+  return true;
+}
+
+DeserializationError deserializeJson(DynamicJsonDocument &doc, const char *input)
+{
+  const char *p = input;
+  JsonNode root;
+  if ( !readjson(p, root) || (root.type != JsonNode::JOBJECT) )
+  {
+    doc.clear();
+    return DeserializationError(true);
+  }
+  doc.root = root;
+  return DeserializationError(false);
+}
+
+DeserializationError deserializeJson(DynamicJsonDocument &doc, const String &input)
+{
+  return deserializeJson(doc, input.c_str());
+}
+
+// ---------------------------------------------------------------------------
+// 9: TEMPERATURE PROBE
+// ---------------------------------------------------------------------------
+static float probetemp = 20.0;
+static bool probepresent = true;
+
+void simsettemp(float celsius)
+{
+  probetemp = celsius;
+}
+
+void simsetprobe(bool present)
+{
+  probepresent = present;
+}
+
+uint8_t DallasTemperature::getDeviceCount(void)
+{
+  return probepresent ? 1 : 0;
+}
+
+bool DallasTemperature::getAddress(uint8_t *addr, uint8_t index)
+{
+  static const uint8_t probeaddr[8] = { 0x28, 0xFF, 0x4B, 0x6A, 0x01, 0x17, 0x04, 0x5C };
+  if ( !probepresent || (index != 0) )
+  {
+    return false;
+  }
+  memcpy(addr, probeaddr, sizeof(probeaddr));
+  return true;
+}
+
+float DallasTemperature::getTempCByIndex(uint8_t index)
+{
+  return (probepresent && (index == 0)) ? probetemp : -127.0;
+}
@@ -0,0 +1,92 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP HOST BUILD - SIMULATED PERIPHERALS
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+// hal.h includes this instead of the Arduino core headers when HOSTBUILD is defined. The functions
+// below are the test's side of the simulated peripherals: the clock, input pins, tcp connections,
+// the file system and the temperature probe. Simulated time only moves on in simadvance(), delay()
+// and simrun(), a motor timer armed with simsettimer() ticks as time passes.
+
+#ifndef hostsim_h
+#define hostsim_h
+
+#include <Arduino.h>
+#include <FS.h>
+#include <ESP8266WiFi.h>
+#include <ESP8266WebServer.h>
+#include <WiFiServer.h>
+#include <WiFiClient.h>
+
+// ---------------------------------------------------------------------------
+// 1: TIME AND TIMER
+// ---------------------------------------------------------------------------
+
+// move the clock on by us, running every timer tick that falls due on the way
+void simadvance(unsigned long us);
+
+// the motor timer, isr is called every periodus until simstoptimer(), the isr may change the period
+void simsettimer(void (*isr)(void), unsigned long periodus);
+void simsetperiod(unsigned long periodus);
+void simstoptimer(void);
+bool simtimerarmed(void);
+
+// run setup(), or loop() for ms of simulated time with looppassus between passes
+void simsetup(void);
+void simrun(unsigned long ms, unsigned long looppassus = 100);
+
+// ---------------------------------------------------------------------------
+// 2: GPIO
+// ---------------------------------------------------------------------------
+
+// drive an input pin from outside, an interrupt attached to the pin runs on a change
+void simsetpin(uint8_t pin, int level);
+int  simgetpin(uint8_t pin);
+
+// ---------------------------------------------------------------------------
+// 3: TCP CONNECTIONS
+// ---------------------------------------------------------------------------
+
+// the test's end of a tcp connection to the focuser, simconnect() queues it for myserver.available()
+class SimClient
+{
+  public:
+    SimClient(void) { }
+    explicit SimClient(const std::shared_ptr<simconnection_t> &c) : conn(c) { }
+    void send(const std::string &s)        { conn->rx.insert(conn->rx.end(), s.begin(), s.end()); }
+    void send(const uint8_t *data, size_t len)  { conn->rx.insert(conn->rx.end(), data, data + len); }
+    std::string receive(void)              { std::string s; s.swap(conn->tx); return s; }
+    void reserve(size_t n)                 { conn->tx.reserve(n); }     // room for the replies, so writes do not allocate
+    void discard(void)                     { conn->tx.clear(); }        // drop the replies, keeping the room
+    bool pending(void) const               { return !conn->rx.empty(); }
+    bool isopen(void) const                { return conn->open; }
+    unsigned long writes(void) const       { return conn->writes; }
+    void close(void)                       { conn->open = false; }
+  private:
+    std::shared_ptr<simconnection_t> conn;
+};
+
+SimClient simconnect(void);
+
+// ---------------------------------------------------------------------------
+// 4: FILE SYSTEM, SERIAL PORT, PROBE, RESTART
+// ---------------------------------------------------------------------------
+
+simfiles_t &simfiles(void);
+void simformat(void);
+
+void simserialin(const std::string &s);
+std::string simserialout(void);
+
+void simsettemp(float celsius);
+void simsetprobe(bool present);
+
+unsigned long simrestarts(void);
+
+#endif
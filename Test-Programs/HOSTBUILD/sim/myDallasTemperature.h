@@ -0,0 +1,36 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP HOST BUILD - SIMULATED DS18B20 PROBE
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+// one probe on the bus, present and reading the temperature set with simsettemp()
+
+#ifndef DallasTemperature_h
+#define DallasTemperature_h
+
+#include <Arduino.h>
+#include <OneWire.h>
+
+typedef uint8_t DeviceAddress[8];
+
+class DallasTemperature
+{
+  public:
+    explicit DallasTemperature(OneWire *) { }
+    void    begin(void) { }
+    uint8_t getDeviceCount(void);
+    bool    getAddress(uint8_t *addr, uint8_t index);
+    bool    setResolution(const uint8_t *, uint8_t bits)   { resolution = bits; return true; }
+    void    setWaitForConversion(bool) { }
+    void    requestTemperatures(void) { }
+    float   getTempCByIndex(uint8_t index);
+    uint8_t resolution = 12;
+};
+
+#endif
@@ -0,0 +1,19 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP HOST BUILD - SIMULATED SSD1306 ASCII DRIVER
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+#ifndef SSD1306AsciiWire_h
+#define SSD1306AsciiWire_h
+
+class SSD1306AsciiWire
+{
+};
+
+#endif
@@ -0,0 +1,292 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP HOST BUILD - SIMULATED DRIVER BOARD
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include "hostsim.h"
+#include "generalDefinitions.h"
+#include "myBoards.h"
+#include "rampTable.h"
+#include "stepTimer.h"
+#include "simboard.h"
+
+const char* DRVBRD_ID = "PRO2ESP32DRV8825";
+
+volatile bool timerSemaphore = false;
+volatile uint32_t stepcount = 0;
+volatile uint32_t backlashcount = 0;                          // backlash steps to take before stepcount
+volatile bool stepjob = false;
+bool stepdir;
+byte reverse_dir;
+extern DriverBoard* driverboard;
+extern bool HPS_alert(void);
+#ifdef TIMEMOVESTART
+volatile uint32_t movecmdtime = 0;
+volatile uint32_t firststeptime = 0;
+#endif
+
+volatile byte homephase = HOMEIDLE;
+volatile bool homeedge = false;
+
+uint16_t activeramp[RAMPTABLESIZE];
+uint32_t activerampaccel = 1;
+volatile uint32_t rampinc = 0;
+volatile uint32_t rampidx = 0;
+volatile uint32_t rampfirst = 0;
+volatile uint32_t ramptop = 0;
+volatile uint32_t rampsteps = 0;
+
+simboard_t simboard;
+
+void simboardswitch(void)
+{
+  if ( simboard.switchat != SIMNOSWITCH )
+  {
+    simsetpin(HPSWPIN, (simboard.motorposition <= simboard.switchat) ? LOW : HIGH);
+  }
+}
+
+// the ISRs of myBoards.cpp without the hardware, the decisions are the firmware's own from stepTimer.h
+void hpswisr(void)
+{
+  if ( homeswitchedge(!digitalRead(HPSWPIN)) )
+  {
+    stepstop();
+  }
+}
+
+// the switch pin is set after the step, as the GPIO interrupt only runs once the timer ISR returns
+void onTimer()
+{
+  byte action = steptick(HPS_alert());
+  if ( action == STEPTICKBACKLASH )
+  {
+    driverboard->movemotor(stepdir, false);
+  }
+  else if ( action == STEPTICKSTEP )
+  {
+    driverboard->movemotor(stepdir, true);
+#ifdef TIMEMOVESTART
+    if ( firststeptime == 0 )
+    {
+      firststeptime = micros();
+    }
+#endif
+    if ( rampinc )
+    {
+      simsetperiod(nextstepdelay());
+    }
+  }
+  else
+  {
+    simstoptimer();
+    stepstopped();
+  }
+  simboardswitch();
+}
+
+DriverBoard::DriverBoard(byte brdtype, unsigned long startposition) : boardtype(brdtype)
+{
+  this->clock_frequency = ESP.getCpuFreqMHz();
+  this->pulsecycles = MOTORPULSETIME * this->clock_frequency;
+  this->lastdir = 0xff;
+  this->stepdelay = MSPEED;
+  this->accel = 0;
+  this->maxspeeddelay = MSPEED;
+  this->drvbrdleds = false;
+  pinMode(ENABLEPIN, OUTPUT);
+  pinMode(DIRPIN, OUTPUT);
+  pinMode(STEPPIN, OUTPUT);
+  digitalWrite(ENABLEPIN, 1);
+  setstepmode(STEP1);
+  this->focuserposition = startposition;
+}
+
+DriverBoard::~DriverBoard()
+{
+  simstoptimer();
+}
+
+int DriverBoard::getstepmode(void)
+{
+  return this->stepmode;
+}
+
+void DriverBoard::setstepmode(int smode)
+{
+  switch ( smode )
+  {
+    case STEP1:
+    case STEP2:
+    case STEP4:
+    case STEP8:
+    case STEP16:
+    case STEP32:
+      this->stepmode = smode;
+      break;
+    default:
+      this->stepmode = STEP1;
+      break;
+  }
+  DriverBoard::loadramp();
+}
+
+void DriverBoard::enablemotor(void)
+{
+  digitalWrite(ENABLEPIN, 0);
+}
+
+void DriverBoard::releasemotor(void)
+{
+  digitalWrite(ENABLEPIN, 1);
+}
+
+void DriverBoard::movemotor(byte dir, bool updatefpos)
+{
+  simboard.motorposition += ( dir == moving_in ) ? -1 : 1;
+  simboard.steps++;
+  if ( updatefpos )
+  {
+    ( stepdir == moving_in ) ? this->focuserposition-- : this->focuserposition++;
+  }
+  if ( simboard.onstep )
+  {
+    simboard.onstep();
+  }
+}
+
+void DriverBoard::halt(void)
+{
+  simstoptimer();
+}
+
+void DriverBoard::initmove(bool dir, unsigned long steps, byte motorspeed, bool leds, byte reversedir, unsigned long backlash)
+{
+  stepcount = steps;
+  backlashcount = backlash;
+  stepdir = dir;
+  reverse_dir = reversedir;
+  DriverBoard::enablemotor();
+  drvbrdleds = leds;
+  timerSemaphore = false;
+
+  unsigned long curspd = DriverBoard::getstepdelay();
+  switch ( motorspeed )
+  {
+    case 0: // slow, 1/3rd the speed
+      curspd *= 3;
+      break;
+    case 1: // med, 1/2 the speed
+      curspd *= 2;
+      break;
+  }
+  curspd = DriverBoard::initramp(curspd);
+  simboard.moves++;
+  simboard.moveus = micros();
+  simboard.lastdir = dir;
+  simboard.laststeps = steps;
+  simboard.lastbacklash = backlash;
+  simboard.lastdelay = curspd;
+  if ( simboard.onmove )
+  {
+    simboard.onmove();
+  }
+  simsettimer(onTimer, curspd);
+}
+
+unsigned long DriverBoard::initramp(unsigned long startdelay)
+{
+  if ( this->accel > 0 )
+  {
+    rampstart(this->accel, startdelay, this->maxspeeddelay);
+  }
+  else
+  {
+    rampinc = 0;
+  }
+  return startdelay;
+}
+
+// the firmware copies a table generated at compile time, the same table is generated here at run time
+void DriverBoard::loadramp(void)
+{
+  const ramptable_t table = ramptable(this->stepmode);
+  memcpy(activeramp, table.sdelay, sizeof(activeramp));
+  activerampaccel = rampaccel(this->stepmode);
+}
+
+int DriverBoard::getstepdelay(void)
+{
+  return this->stepdelay;
+}
+
+void DriverBoard::setstepdelay(int sdelay)
+{
+  this->stepdelay = sdelay;
+}
+
+int DriverBoard::getaccel(void)
+{
+  return this->accel;
+}
+
+void DriverBoard::setaccel(int newaccel)
+{
+  this->accel = (newaccel < 0) ? 0 : newaccel;
+}
+
+int DriverBoard::getmaxspeeddelay(void)
+{
+  return this->maxspeeddelay;
+}
+
+void DriverBoard::setmaxspeeddelay(int newdelay)
+{
+  this->maxspeeddelay = (newdelay < MINSTEPDELAY) ? MINSTEPDELAY : newdelay;
+}
+
+void DriverBoard::inithomeswitch(void)
+{
+  attachInterrupt(digitalPinToInterrupt(HPSWPIN), hpswisr, CHANGE);
+}
+
+void DriverBoard::sethomephase(byte phase)
+{
+  homeedge = false;
+  homephase = phase;
+}
+
+bool DriverBoard::gethomeedge(void)
+{
+  return homeedge;
+}
+
+#ifdef STEPTIMING
+// there is no cycle counter to time the simulated ISR, the probe reports no samples
+void DriverBoard::getsteptiming(steptiming_t* st)
+{
+  memset(st, 0, sizeof(steptiming_t));
+  st->mhz = this->clock_frequency;
+}
+
+void DriverBoard::resetsteptiming(void)
+{
+}
+#endif
+
+unsigned long DriverBoard::getposition(void)
+{
+  return this->focuserposition;
+}
+
+void DriverBoard::setposition(unsigned long pos)
+{
+  this->focuserposition = pos;
+}
@@ -0,0 +1,44 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP HOST BUILD - SIMULATED DRIVER BOARD
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+// simboard.cpp implements the DriverBoard class of myBoards.h for the host build. Steps are taken by
+// a timer ISR on the simulated clock with the same rules as onTimer() in myBoards.cpp, the motor
+// moves a simulated shaft and the home position switch closes when the shaft reaches switchat.
+
+#ifndef simboard_h
+#define simboard_h
+
+#include <limits.h>
+#include <Arduino.h>
+
+#define SIMNOSWITCH           LONG_MIN      // switchat when there is no home position switch
+
+struct simboard_t
+{
+  long motorposition = 0;                       // steps the shaft has turned, backlash steps included
+  long switchat = SIMNOSWITCH;                  // home position switch is closed at or below this shaft position
+  unsigned long steps = 0;                      // steps taken since the start
+  unsigned long moves = 0;                      // initmove() calls
+  unsigned long moveus = 0;                     // micros() at the last initmove()
+  bool lastdir = false;                         // arguments of the last initmove()
+  unsigned long laststeps = 0;
+  unsigned long lastbacklash = 0;
+  unsigned long lastdelay = 0;                  // step interval the move was started at
+  void (*onmove)(void) = nullptr;               // called from initmove(), for timing the move start
+  void (*onstep)(void) = nullptr;               // called after each step, backlash steps included
+};
+
+extern simboard_t simboard;
+
+// set the home position switch pin from the shaft position
+void simboardswitch(void);
+
+#endif
@@ -0,0 +1,67 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP HOST BUILD - HOME POSITION SWITCH TEST
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+// Moves in onto the home position switch and checks the focuser backs off, comes back to the closing
+// edge and ends at position 0. Then again with the switch closing before the first step of the slow
+// approach (contact bounce at the edge), which must not leave the focuser waiting for a move that
+// never ran.
+
+#include "hosttest.h"
+#include "generalDefinitions.h"
+#include "simboard.h"
+
+static bool bounce = false;
+
+// close the switch where the shaft is when the slow approach starts
+static void onmove(void)
+{
+  if ( bounce && (simboard.lastdir == (bool) moving_in) && (simboard.laststeps == HOMESTEPS) )
+  {
+    simboard.switchat = simboard.motorposition;
+    simboardswitch();
+  }
+}
+
+static void home(SimClient &client, const char *name)
+{
+  command(client, ":315000#");
+  simboard.motorposition = 5000;
+  simboard.switchat = 4800;
+  simboardswitch();
+  command(client, ":054000#");
+  simrun(10000, 1000);
+  std::string moving = command(client, ":01#");
+  std::string pos = command(client, ":00#");
+  if ( (moving != "I0#") || (pos != "P0#") )
+  {
+    printf("%s: focuser is %s %s after homing\n", name, moving.c_str(), pos.c_str());
+    testfailures++;
+  }
+  CHECK(simboard.motorposition <= simboard.switchat);
+  CHECK(!simtimerarmed());
+}
+
+int main(void)
+{
+  simsetup();
+  SimClient client = simconnect();
+  simrun(10);
+  simboard.onmove = onmove;
+  command(client, ":991#");
+
+  home(client, "home");
+  CHECKEQ(simboard.switchat, 4800L);
+
+  bounce = true;
+  home(client, "switch closed before the approach");
+
+  return testresult("test_homing");
+}
@@ -0,0 +1,163 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP HOST BUILD - HARDWARE STEP PLANNER TEST
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+// Drives HWStepPlanner (hwStepPlanner.h) with a PCNT model: the counter goes up one per pulse,
+// raises the threshold event at remainder() and resets to 0 with the limit event at segsteps.
+// Checks that LEDC is stopped one pulse before the end of every move, that the last pulse made as
+// hwlaststep() does ends the move on the target, that pulses LEDC made after the event are counted,
+// and that the ramp is the same going up and coming down.
+
+#include "hosttest.h"
+#include "generalDefinitions.h"
+#include "myBoards.h"
+#include "rampTable.h"
+#include "hwStepPlanner.h"
+
+// one PCNT unit counting LEDC pulses
+struct pcnt_t
+{
+  uint32_t count = 0;
+  uint32_t segsteps = 0;
+  uint32_t thres = 0;
+};
+
+// count one pulse, returns true if the planner says the move is complete
+static bool pulse(HWStepPlanner &p, pcnt_t &c)
+{
+  bool done = false;
+  c.count++;
+  if ( c.count == c.segsteps )
+  {
+    c.count = 0;
+    done = p.onlimit();
+  }
+  if ( c.thres && (c.count == c.thres) )
+  {
+    done = done || p.onthreshold();
+  }
+  return done;
+}
+
+// late is the LEDC pulses finished after the stop event, before the interrupt stopped LEDC
+static void checkmove(uint32_t total, uint32_t segsteps, uint32_t late)
+{
+  HWStepPlanner p;
+  pcnt_t c;
+  p.begin(total, segsteps);
+  c.segsteps = segsteps;
+  c.thres = p.remainder();
+
+  uint32_t pulses = 0;
+  bool done = false;
+  while ( !done && (pulses < total + segsteps) )
+  {
+    done = pulse(p, c);
+    pulses++;
+  }
+  if ( pulses != total - 1 )
+  {
+    printf("move of %u, segments of %u: LEDC stopped after %u pulses\n", total, segsteps, pulses);
+    testfailures++;
+  }
+  CHECKEQ(p.stepsafterstop(c.count), total - 1);
+
+  // the counter keeps counting after the event, its limit interrupt is ignored once the move stopped
+  for ( uint32_t i = 0; i < late; i++ )
+  {
+    c.count = (c.count + 1) % segsteps;
+  }
+  uint32_t steps = p.stepsafterstop(c.count);
+  if ( steps < p.steps() )
+  {
+    steps++;                          // hwpulse()
+  }
+  CHECKEQ(steps, (late < 2) ? total : total - 1 + late);
+}
+
+int main(void)
+{
+  const uint32_t seg = HWSEGMENTSTEPS;
+  const uint32_t totals[] = { 1, 2, 100, seg - 1, seg, seg + 1, 2 * seg, 2 * seg + 1, 3 * seg + 7, 10 * seg - 1 };
+  for ( uint32_t total : totals )
+  {
+    if ( total > 1 )
+    {
+      checkmove(total, seg, 0);
+      checkmove(total, seg, 1);
+      checkmove(total, seg, 3);
+    }
+  }
+  checkmove(7, 3, 2);
+  checkmove(9, 3, 1);
+  checkmove(10, 3, 2);
+
+  // a single step is made without LEDC
+  HWStepPlanner one;
+  one.begin(1, seg);
+  CHECKEQ(one.ledcsteps(), 0U);
+
+  // no ramp, every step at the start interval
+  HWStepPlanner p;
+  p.begin(1000, seg);
+  p.setramp(nullptr, 4000, 0, 0, 0);
+  CHECKEQ(p.sdelay(0), 4000U);
+  CHECKEQ(p.sdelay(999), 4000U);
+
+  // ramp on the STEP1 table, symmetric, never past the top speed, overshoot reads the start of the ramp
+  static ramptable_t table;
+  table = ramptable(STEP1);
+  rampplan_t plan = { 0, 0, 0 };
+  CHECK(rampplan(table.sdelay, rampaccel(STEP1), 2000, table.sdelay[0], MINSTEPDELAY, &plan));
+  const uint32_t total = 3 * seg + 11;
+  p.begin(total, seg);
+  p.setramp(table.sdelay, table.sdelay[0], plan.first, plan.top, plan.inc);
+  uint32_t topdelay = table.sdelay[plan.top >> RAMPFRACBITS];
+  bool symmetric = true;
+  bool abovetop = true;
+  bool slows = true;
+  uint32_t last = p.sdelay(0);
+  for ( uint32_t n = 0; n <= total; n++ )
+  {
+    // sdelay() takes the PCNT count in the current segment, walk it as onlimit() would
+    HWStepPlanner q;
+    q.begin(total, seg);
+    q.setramp(table.sdelay, table.sdelay[0], plan.first, plan.top, plan.inc);
+    for ( uint32_t b = seg; b <= n; b += seg )
+    {
+      q.onlimit();
+    }
+    uint32_t d = q.sdelay(n % seg);
+    HWStepPlanner r;
+    r.begin(total, seg);
+    r.setramp(table.sdelay, table.sdelay[0], plan.first, plan.top, plan.inc);
+    for ( uint32_t b = seg; b <= (total - n); b += seg )
+    {
+      r.onlimit();
+    }
+    symmetric = symmetric && (d == r.sdelay((total - n) % seg));
+    abovetop = abovetop && (d >= topdelay);
+    slows = slows && ((n < total / 2) ? (d <= last) : (d >= last));
+    last = d;
+  }
+  CHECK(symmetric);
+  CHECK(abovetop);
+  CHECK(slows);
+  CHECKEQ(p.sdelay(0), (uint32_t) table.sdelay[0]);
+
+  // after the last step, as the timer ISR may read it before hwfinish(), the ramp stays at its start
+  for ( uint32_t b = seg; b <= total; b += seg )
+  {
+    p.onlimit();
+  }
+  CHECKEQ(p.sdelay(total % seg + 2), (uint32_t) table.sdelay[0]);
+
+  return testresult("test_hwplanner");
+}
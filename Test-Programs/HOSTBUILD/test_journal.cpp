@@ -0,0 +1,90 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP HOST BUILD - POSITION JOURNAL TEST
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+// Damages /data_pos.jnl the way a reset during a write does, a torn last record or a record with a
+// bad crc, and checks the boot after it finds the last good position and that the moves made after
+// that boot are found by the next one. A reboot command during a move must journal where it stopped.
+
+#include "hosttest.h"
+#include "FocuserSetupData.h"
+
+static const char *journal = "/data_pos.jnl";
+
+static std::string &journalfile(void)
+{
+  return *simfiles()[journal];
+}
+
+// boot, and return the position the focuser reports. The firmware's globals are not cleared by
+// simsetup(), so the old connection is closed first to free its client slot
+static std::string boot(SimClient &client)
+{
+  static bool booted = false;
+  if ( booted )
+  {
+    client.close();
+    simrun(10);
+  }
+  simsetup();
+  booted = true;
+  client = simconnect();
+  simrun(10);
+  return command(client, ":00#");
+}
+
+static void moveto(SimClient &client, const char *frame)
+{
+  command(client, frame);
+  simrun(5000);
+}
+
+int main(void)
+{
+  SimClient client;
+  CHECKEQ(boot(client), std::string("P5000#"));
+  moveto(client, ":055100#");
+  CHECKEQ(journalfile().size() % sizeof(posrecord_t), 0U);
+
+  // torn record at the end, the records appended after the next boot must still line up
+  journalfile().append(5, '\x55');
+  CHECKEQ(boot(client), std::string("P5100#"));
+  CHECKEQ(journalfile().size() % sizeof(posrecord_t), 0U);
+  moveto(client, ":055200#");
+  CHECKEQ(boot(client), std::string("P5200#"));
+
+  // bad crc in the last record, the one before it is the position
+  moveto(client, ":055300#");
+  std::string &f = journalfile();
+  f[f.size() - 1] ^= 0x01;
+  CHECKEQ(boot(client), std::string("P5200#"));
+  moveto(client, ":055400#");
+  CHECKEQ(boot(client), std::string("P5400#"));
+
+  // nothing but a torn record, the journal is dropped and a new one started
+  journalfile().assign(3, '\x55');
+  boot(client);
+  CHECKEQ(journalfile().size() % sizeof(posrecord_t), 0U);
+  moveto(client, ":055500#");
+  CHECKEQ(boot(client), std::string("P5500#"));
+
+  // reboot during a move, the position the motor stopped at is journalled before the restart
+  command(client, ":059000#");
+  simrun(300);
+  client.send(":40#");
+  simrun(10);
+  CHECKEQ(simrestarts(), 1UL);
+  std::string stopped = command(client, ":00#");
+  long stoppedat = atol(stopped.c_str() + 1);
+  CHECK((stoppedat > 5500) && (stoppedat < 9000));
+  CHECKEQ(boot(client), stopped);
+
+  return testresult("test_journal");
+}
@@ -0,0 +1,72 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP HOST BUILD - MOVE NOTIFICATION TEST
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+// One client subscribes with :86xx#, a second one does not. During a move the subscriber gets the
+// start frame, a position frame every xx steps and the done frame, the other client gets nothing.
+
+#include <vector>
+#include "hosttest.h"
+#include "generalDefinitions.h"
+
+static std::vector<std::string> frames(const std::string &s)
+{
+  std::vector<std::string> v;
+  size_t start = 0;
+  size_t end;
+  while ( (end = s.find('#', start)) != std::string::npos )
+  {
+    v.push_back(s.substr(start, end - start + 1));
+    start = end + 1;
+  }
+  return v;
+}
+
+int main(void)
+{
+  simsetup();
+  SimClient sub = simconnect();
+  SimClient other = simconnect();
+  simrun(10);
+
+  command(sub, ":8625#");
+  CHECKEQ(sub.receive(), std::string());
+  command(other, ":055100#");
+  simrun(3000);
+
+  std::vector<std::string> got = frames(sub.receive());
+  CHECKEQ(other.receive(), std::string());
+  CHECK(got.size() >= 2);
+  if ( got.size() >= 2 )
+  {
+    CHECKEQ(got.front(), std::string("j0,5000#"));
+    CHECKEQ(got.back(), std::string("j2,5100#"));
+  }
+  // position frames at least 25 steps apart, in order
+  unsigned long last = 5000;
+  int positions = 0;
+  for ( size_t i = 1; i + 1 < got.size(); i++ )
+  {
+    unsigned long pos = strtoul(got[i].c_str() + 3, nullptr, 10);
+    CHECK(got[i].compare(0, 3, "j1,") == 0);
+    CHECK(pos >= last + 25);
+    last = pos;
+    positions++;
+  }
+  CHECKEQ(positions, 4);
+
+  // unsubscribed, nothing on the next move
+  command(sub, ":860#");
+  command(other, ":055000#");
+  simrun(3000);
+  CHECKEQ(sub.receive(), std::string());
+
+  return testresult("test_notify");
+}
@@ -0,0 +1,112 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP HOST BUILD - PROTOCOL CONFORMANCE TEST
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+// Sends every opcode in cmdtable over the tcp port and checks the reply against its entry:
+//   no handler                       no reply, with or without an argument
+//   reply token                      one frame, token first, '#' last, no '#' inside
+//   no reply token                   nothing sent back
+//   argument expected but missing    rejected, no reply
+// and that the tcp framing drops what is not a complete frame.
+// Setters that move the focuser, restart it, reset the settings or switch to binary frames are only
+// sent without their argument (rejected), the other tests cover them.
+
+#include <set>
+#include "hosttest.h"
+#include "hostcmd.h"
+#include "generalDefinitions.h"
+
+static std::string frame(int opcode, const char *arg)
+{
+  char buf[16];
+  snprintf(buf, sizeof(buf), ":%02d%s#", opcode, arg);
+  return buf;
+}
+
+static const char *samplearg(char arg)
+{
+  switch ( arg )
+  {
+    case HOSTCMDARG_DIGIT:
+    case HOSTCMDARG_INT:
+    case HOSTCMDARG_TEXT:
+      return "1";
+    case HOSTCMDARG_FLOAT:
+      return "1.0";
+    default:
+      return "";
+  }
+}
+
+static void checkreply(int opcode, const std::string &sent, const std::string &reply, char token)
+{
+  bool ok;
+  if ( token == 0 )
+  {
+    ok = reply.empty();
+  }
+  else
+  {
+    ok = (reply.size() >= 2) && (reply[0] == token) && (reply.back() == '#') && (reply.find('#') == reply.size() - 1);
+  }
+  if ( !ok )
+  {
+    printf("opcode %02d: %s got \"%s\", expected %s\n", opcode, sent.c_str(), reply.c_str(),
+           token ? "one frame with its token" : "no reply");
+    testfailures++;
+  }
+}
+
+int main(void)
+{
+  const std::set<int> notrun = { 5, 28, 40, 42, 59, 64 };
+
+  simsetup();
+  SimClient client = simconnect();
+  simrun(10);
+  CHECKEQ(hostcmdcount(), 100);
+
+  int supported = 0;
+  for ( int op = 0; op < hostcmdcount(); op++ )
+  {
+    hostcmd_t c = hostcmd(op);
+    if ( !c.supported )
+    {
+      checkreply(op, frame(op, ""), command(client, frame(op, ""), 5), 0);
+      checkreply(op, frame(op, "1"), command(client, frame(op, "1"), 5), 0);
+      continue;
+    }
+    supported++;
+    if ( c.arg == HOSTCMDARG_NONE )
+    {
+      if ( (c.token != 0) || (notrun.count(op) == 0) )
+      {
+        checkreply(op, frame(op, ""), command(client, frame(op, ""), 5), c.token);
+      }
+      continue;
+    }
+    // argument missing, rejected
+    checkreply(op, frame(op, ""), command(client, frame(op, ""), 5), 0);
+    if ( notrun.count(op) == 0 )
+    {
+      std::string f = frame(op, samplearg(c.arg));
+      checkreply(op, f, command(client, f, 5), c.token);
+    }
+  }
+  printf("%d of %d opcodes supported\n", supported, hostcmdcount());
+
+  // anything before the ':' of a frame is dropped, a frame longer than CMDBUFFERSIZE is dropped whole
+  CHECKEQ(command(client, "xx:00#"), std::string("P1#"));
+  CHECKEQ(command(client, ":00" + std::string(CMDBUFFERSIZE, '1') + "#", 5), std::string());
+  CHECKEQ(command(client, ":01#"), std::string("I0#"));
+  CHECK(client.isopen());
+
+  return testresult("test_protocol");
+}
@@ -0,0 +1,64 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP HOST BUILD - ACCELERATION RAMP TEST
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+// Checks rampplan() from rampTable.h on the tables of every step mode: a move that starts slower
+// than the table runs without a ramp, and the acceleration a move gets is the one asked for, also
+// for small accelerations at STEP32 where the index increment is a small fraction of an entry.
+
+#include <math.h>
+#include "hosttest.h"
+#include "generalDefinitions.h"
+#include "myBoards.h"
+#include "rampTable.h"
+
+int main(void)
+{
+  const uint32_t modes[] = { STEP1, STEP2, STEP4, STEP8, STEP16, STEP32 };
+  const uint32_t accels[] = { 100, 250, 1000, 5000, 20000 };
+
+  for ( uint32_t smode : modes )
+  {
+    static ramptable_t table;
+    table = ramptable(smode);
+    const uint16_t *t = table.sdelay;
+    uint32_t taccel = rampaccel(smode);
+    uint32_t topdelay = t[RAMPTABLESIZE - 1];
+    rampplan_t plan = { 0, 0, 0 };
+
+    // no acceleration, or the start is at the top speed
+    CHECK(!rampplan(t, taccel, 0, t[0], topdelay, &plan));
+    CHECK(!rampplan(t, taccel, 1000, topdelay, topdelay, &plan));
+
+    // start slower than the table, the second step would otherwise jump to the table's start speed
+    CHECK(!rampplan(t, taccel, 1000, (uint32_t) t[0] + 1, topdelay, &plan));
+    CHECK(!rampplan(t, taccel, 1000, (uint32_t) t[0] * 3, topdelay, &plan));
+
+    // start at the first entry of the table, the first step is never faster than the start speed
+    CHECK(rampplan(t, taccel, 1000, t[0], topdelay, &plan));
+    CHECKEQ(plan.first, 0U);
+    CHECK(t[plan.first >> RAMPFRACBITS] <= t[0]);
+    CHECK(t[plan.top >> RAMPFRACBITS] <= topdelay);
+
+    // the index walks v^2 = 2 * taccel * (i + 1), so each step adds 2 * taccel * inc to v^2 and the
+    // acceleration is taccel * inc, which must be within 5% of the one asked for
+    for ( uint32_t accel : accels )
+    {
+      CHECK(rampplan(t, taccel, accel, t[0], topdelay, &plan));
+      double got = (double) taccel * plan.inc / (double) (1UL << RAMPFRACBITS);
+      if ( fabs(got - accel) > 0.05 * accel )
+      {
+        printf("STEP%u accel %u: ramp accelerates at %.0f steps/s/s\n", smode, accel, got);
+        testfailures++;
+      }
+    }
+  }
+  return testresult("test_ramp");
+}
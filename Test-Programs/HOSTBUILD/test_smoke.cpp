@@ -0,0 +1,46 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP HOST BUILD - SMOKE TEST
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+// Boots the firmware on a blank file system, reads the position, moves the focuser and checks the
+// position survives a restart through the position journal.
+
+#include "hosttest.h"
+#include "generalDefinitions.h"
+#include "simboard.h"
+
+extern void setup(void);
+
+int main(void)
+{
+  simsetup();
+  SimClient client = simconnect();
+  simrun(10);
+
+  CHECKEQ(command(client, ":00#"), std::string("P5000#"));
+
+  command(client, ":055100#");
+  CHECKEQ(simboard.moves, 1UL);
+  CHECKEQ(simboard.laststeps, 100UL);
+  CHECKEQ(simboard.lastdir, (bool) moving_out);
+  simrun(5000);
+  CHECKEQ(command(client, ":01#"), std::string("I0#"));
+  CHECKEQ(command(client, ":00#"), std::string("P5100#"));
+
+  // the journal is on the file system, a second boot from it finds the same position
+  simrun(5000);
+  CHECK(simfiles().count("/data_pos.jnl") == 1);
+  simsetup();
+  SimClient client2 = simconnect();
+  simrun(10);
+  CHECKEQ(command(client2, ":00#"), std::string("P5100#"));
+
+  return testresult("test_smoke");
+}
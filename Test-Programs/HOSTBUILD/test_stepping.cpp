@@ -0,0 +1,140 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP HOST BUILD - TIMER ISR STEPPING TEST
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+// Runs moves through the timer ISR decisions in stepTimer.h, the code myBoards.cpp uses, and checks
+// the steps the simulated driver board sees: the backlash steps come first and leave the position
+// alone, then the move speeds up along the ramp to the top speed and slows down again over as many
+// steps, or runs at the start interval when there is no acceleration.
+
+#include <vector>
+#include "hosttest.h"
+#include "generalDefinitions.h"
+#include "myBoards.h"
+#include "rampTable.h"
+#include "simboard.h"
+
+extern DriverBoard* driverboard;
+
+struct steprec_t
+{
+  unsigned long us;
+  unsigned long position;
+};
+
+static std::vector<steprec_t> steps;
+
+static void onstep(void)
+{
+  steps.push_back({ micros(), driverboard->getposition() });
+}
+
+// move from 5000 out to 5000 + n with backlash backlash, returns the intervals between the move steps
+static std::vector<unsigned long> move(SimClient &client, unsigned long n, unsigned long backlash)
+{
+  char frame[16];
+  command(client, ":315000#");
+  command(client, ":730#");
+  command(client, ":750#");
+  command(client, ":054990#");                      // last move in, so the next one out takes up backlash
+  simrun(2000, 50);
+  command(client, ":315000#");
+  snprintf(frame, sizeof(frame), ":75%d#", backlash ? 1 : 0);
+  command(client, frame);
+  snprintf(frame, sizeof(frame), ":79%lu#", backlash);
+  command(client, frame);
+
+  steps.clear();
+  snprintf(frame, sizeof(frame), ":05%lu#", 5000 + n);
+  command(client, frame);
+  simrun(30000, 50);
+  CHECKEQ(steps.size(), (size_t) (n + backlash));
+  CHECKEQ(driverboard->getposition(), 5000 + n);
+
+  std::vector<unsigned long> d;
+  for ( size_t i = 0; i < steps.size(); i++ )
+  {
+    if ( i < backlash )
+    {
+      CHECKEQ(steps[i].position, 5000UL);
+    }
+    else if ( i > backlash )
+    {
+      d.push_back(steps[i].us - steps[i - 1].us);
+    }
+  }
+  return d;
+}
+
+int main(void)
+{
+  simsetup();
+  SimClient client = simconnect();
+  simrun(10);
+  simboard.onstep = onstep;
+
+  // the ramp table of the step mode in use, the move starts at its first entry
+  static ramptable_t table;
+  table = ramptable(driverboard->getstepmode());
+  const unsigned long startdelay = table.sdelay[0];
+  const unsigned long topdelay = 2 * (unsigned long) table.sdelay[RAMPTABLESIZE - 1];
+  driverboard->setstepdelay(startdelay);
+  driverboard->setmaxspeeddelay(topdelay);
+
+  // no acceleration, every step at the start interval
+  driverboard->setaccel(0);
+  std::vector<unsigned long> d = move(client, 200, 10);
+  bool constant = true;
+  for ( unsigned long us : d )
+  {
+    constant = constant && (us == startdelay);
+  }
+  CHECK(constant);
+
+  // ramp, faster and faster up to the top speed, and slowing down over the same number of steps
+  driverboard->setaccel(5000);
+  d = move(client, 2000, 20);
+  size_t fastest = 0;
+  bool speedsup = true;
+  bool slowsdown = true;
+  for ( size_t i = 1; i < d.size(); i++ )
+  {
+    if ( d[i] < d[fastest] )
+    {
+      fastest = i;
+    }
+    speedsup = speedsup && ((i > d.size() / 2) || (d[i] <= d[i - 1]));
+    slowsdown = slowsdown && ((i <= d.size() / 2) || (d[i] >= d[i - 1]));
+  }
+  CHECK(speedsup);
+  CHECK(slowsdown);
+  CHECK(d.front() <= startdelay);
+  CHECK(d[1] < d[0]);
+  CHECK(d[fastest] <= topdelay);
+  CHECK(d[fastest] >= topdelay - topdelay / 10);
+  size_t up = 0;
+  size_t down = 0;
+  while ( (up < d.size()) && (d[up] > d[fastest]) )
+  {
+    up++;
+  }
+  while ( (down < d.size()) && (d[d.size() - 1 - down] > d[fastest]) )
+  {
+    down++;
+  }
+  if ( (up > down + 1) || (down > up + 1) )
+  {
+    printf("ramp: %zu steps up to top speed, %zu steps down\n", up, down);
+    testfailures++;
+  }
+  CHECKEQ(d.back(), d.front());
+
+  return testresult("test_stepping");
+}
@@ -0,0 +1,353 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP PROTOCOL BENCHMARK CLIENT
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+// Linux client that measures the round trip time of the focuser protocol on SERVERPORT (2020).
+// It replays the poll loop of a typical INDI, ASCOM or APT client against a controller and reports
+// p50/p99/max latency per opcode, commands per second and the cost of a reconnect. Run it with the
+// web and ASCOM servers on and off to see what they cost the protocol.
+//
+// Only query commands are sent, the focuser does not move.
+//
+// Build:  g++ -O2 -std=c++11 -o protocolbench protocolbench.cpp
+// Run:    ./protocolbench 192.168.4.1 [-p port] [-m indi|ascom|apt|status] [-n commands]
+//                         [-c clients] [-r reconnects] [-b]
+//   -n  commands sent by each client, default 1000
+//   -c  clients connected at the same time (the firmware serves up to MAXTCPCLIENTS), default 1
+//   -r  reconnects to time, connect + :02# reply, default 20
+//   -b  use binary frames (:591#), see ESP_BinaryRx() in comms.h
+//
+// Without a controller, Test-Programs/HOSTBUILD/bench_protocol replays the same mixes (protocolmixes.h)
+// against the host build of the firmware, ctest runs it with a short count.
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "protocolmixes.h"
+
+#define SERVERPORT            2020
+#define RXTIMEOUT             2             // seconds to wait for a reply
+
+// ---------------------------------------------------------------------------
+// 1: TIMING AND STATS
+// ---------------------------------------------------------------------------
+
+static double nowus(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (ts.tv_sec * 1000000.0) + (ts.tv_nsec / 1000.0);
+}
+
+static double percentile(std::vector<double> &v, double p)
+{
+  if ( v.empty() )
+  {
+    return 0;
+  }
+  std::sort(v.begin(), v.end());
+  size_t idx = (size_t) (p * (v.size() - 1) + 0.5);
+  return v[idx];
+}
+
+struct stats_t
+{
+  std::mutex lock;
+  std::map<int, std::vector<double>> rtt;      // round trip time in uS per opcode
+  long errors = 0;
+};
+
+// ---------------------------------------------------------------------------
+// 2: CONNECTION
+// ---------------------------------------------------------------------------
+
+static int openclient(const char *host, int port)
+{
+  struct addrinfo hints, *res;
+  char portstr[8];
+
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  snprintf(portstr, sizeof(portstr), "%d", port);
+  if ( getaddrinfo(host, portstr, &hints, &res) != 0 )
+  {
+    return -1;
+  }
+  int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+  if ( fd >= 0 )
+  {
+    int one = 1;
+    struct timeval tv = { RXTIMEOUT, 0 };
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    if ( connect(fd, res->ai_addr, res->ai_addrlen) != 0 )
+    {
+      close(fd);
+      fd = -1;
+    }
+  }
+  freeaddrinfo(res);
+  return fd;
+}
+
+static bool sendall(int fd, const void *data, size_t len)
+{
+  const uint8_t *p = (const uint8_t *) data;
+  while ( len )
+  {
+    ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+    if ( n <= 0 )
+    {
+      return false;
+    }
+    p += n;
+    len -= n;
+  }
+  return true;
+}
+
+static bool recvall(int fd, void *data, size_t len)
+{
+  uint8_t *p = (uint8_t *) data;
+  while ( len )
+  {
+    ssize_t n = recv(fd, p, len, 0);
+    if ( n <= 0 )
+    {
+      return false;
+    }
+    p += n;
+    len -= n;
+  }
+  return true;
+}
+
+// ---------------------------------------------------------------------------
+// 3: ASCII AND BINARY REQUESTS
+// ---------------------------------------------------------------------------
+
+// :xx# and read the reply up to the #
+static bool asciirequest(int fd, int opcode)
+{
+  char cmd[8];
+  int len = snprintf(cmd, sizeof(cmd), ":%02d#", opcode);
+  if ( !sendall(fd, cmd, len) )
+  {
+    return false;
+  }
+  char c;
+  do
+  {
+    if ( recv(fd, &c, 1, 0) != 1 )
+    {
+      return false;
+    }
+  } while ( c != '#' );
+  return true;
+}
+
+// BINSYNC opcode BIN_NONE 0 0 crc, read the whole reply frame and check its crc
+static bool binaryrequest(int fd, int opcode)
+{
+  uint8_t frame[BINHEADERSIZE + 2];
+  binaryframe(opcode, frame);
+  if ( !sendall(fd, frame, sizeof(frame)) )
+  {
+    return false;
+  }
+  uint8_t header[BINHEADERSIZE];
+  if ( !recvall(fd, header, sizeof(header)) || (header[0] != BINSYNC) )
+  {
+    return false;
+  }
+  int len = header[3] | (header[4] << 8);
+  std::vector<uint8_t> rest(len + 2);
+  if ( !recvall(fd, rest.data(), rest.size()) )
+  {
+    return false;
+  }
+  uint16_t crc = crc16(crc16(0xFFFF, header + 1, BINHEADERSIZE - 1), rest.data(), len);
+  return (crc == (rest[len] | (rest[len + 1] << 8))) && (header[2] != BIN_ERROR);
+}
+
+// ---------------------------------------------------------------------------
+// 4: BENCHMARK
+// ---------------------------------------------------------------------------
+
+struct options_t
+{
+  const char *host = nullptr;
+  int port = SERVERPORT;
+  const mix_t *mix = &mixes[0];
+  long commands = 1000;
+  int clients = 1;
+  int reconnects = 20;
+  bool binary = false;
+};
+
+static void runclient(const options_t *opt, stats_t *stats)
+{
+  int fd = openclient(opt->host, opt->port);
+  if ( fd < 0 )
+  {
+    std::lock_guard<std::mutex> g(stats->lock);
+    stats->errors += opt->commands;
+    return;
+  }
+  if ( opt->binary )
+  {
+    sendall(fd, ":591#", 5);
+  }
+  std::map<int, std::vector<double>> rtt;
+  long errors = 0;
+  const std::vector<int> &ops = opt->mix->opcodes;
+  for ( long i = 0; i < opt->commands; i++ )
+  {
+    int opcode = ops[i % ops.size()];
+    double start = nowus();
+    bool ok = opt->binary ? binaryrequest(fd, opcode) : asciirequest(fd, opcode);
+    if ( ok )
+    {
+      rtt[opcode].push_back(nowus() - start);
+    }
+    else
+    {
+      errors++;
+    }
+  }
+  close(fd);
+
+  std::lock_guard<std::mutex> g(stats->lock);
+  for ( auto &r : rtt )
+  {
+    std::vector<double> &all = stats->rtt[r.first];
+    all.insert(all.end(), r.second.begin(), r.second.end());
+  }
+  stats->errors += errors;
+}
+
+static void usage(void)
+{
+  fprintf(stderr, "usage: protocolbench host [-p port] [-m indi|ascom|apt|status] [-n commands] [-c clients] [-r reconnects] [-b]\n");
+  exit(1);
+}
+
+int main(int argc, char **argv)
+{
+  options_t opt;
+  int c;
+
+  while ( (c = getopt(argc, argv, "p:m:n:c:r:b")) != -1 )
+  {
+    switch ( c )
+    {
+      case 'p':
+        opt.port = atoi(optarg);
+        break;
+      case 'm':
+        opt.mix = nullptr;
+        for ( const mix_t &m : mixes )
+        {
+          if ( strcmp(m.name, optarg) == 0 )
+          {
+            opt.mix = &m;
+          }
+        }
+        if ( opt.mix == nullptr )
+        {
+          usage();
+        }
+        break;
+      case 'n':
+        opt.commands = atol(optarg);
+        break;
+      case 'c':
+        opt.clients = atoi(optarg);
+        break;
+      case 'r':
+        opt.reconnects = atoi(optarg);
+        break;
+      case 'b':
+        opt.binary = true;
+        break;
+      default:
+        usage();
+    }
+  }
+  if ( optind >= argc )
+  {
+    usage();
+  }
+  opt.host = argv[optind];
+
+  // reconnect cost, connect and the first reply, the firmware picks up a new client in loop()
+  std::vector<double> reconnect;
+  for ( int i = 0; i < opt.reconnects; i++ )
+  {
+    double start = nowus();
+    int fd = openclient(opt.host, opt.port);
+    if ( (fd >= 0) && asciirequest(fd, 2) )
+    {
+      reconnect.push_back(nowus() - start);
+    }
+    if ( fd >= 0 )
+    {
+      close(fd);
+    }
+    usleep(50000);                              // let the firmware see the disconnect and free the slot
+  }
+
+  stats_t stats;
+  std::vector<std::thread> threads;
+  double start = nowus();
+  for ( int i = 0; i < opt.clients; i++ )
+  {
+    threads.emplace_back(runclient, &opt, &stats);
+  }
+  for ( std::thread &t : threads )
+  {
+    t.join();
+  }
+  double elapsed = (nowus() - start) / 1000000.0;
+
+  long done = 0;
+  printf("mix %s, %d client(s), %s frames\n", opt.mix->name, opt.clients, opt.binary ? "binary" : "ascii");
+  printf("opcode  count     p50(ms)   p99(ms)   max(ms)\n");
+  for ( auto &r : stats.rtt )
+  {
+    std::vector<double> &v = r.second;
+    std::sort(v.begin(), v.end());
+    done += v.size();
+    printf(":%02d#   %-8zu  %-8.2f  %-8.2f  %-8.2f\n", r.first, v.size(), percentile(v, 0.50) / 1000.0,
+           percentile(v, 0.99) / 1000.0, v.back() / 1000.0);
+  }
+  printf("commands/sec %.1f, errors %ld\n", done / elapsed, stats.errors);
+  printf("reconnect    %zu ok, p50 %.2fms, p99 %.2fms\n", reconnect.size(), percentile(reconnect, 0.50) / 1000.0,
+         percentile(reconnect, 0.99) / 1000.0);
+  return (stats.errors == 0) ? 0 : 2;
+}
@@ -0,0 +1,68 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP PROTOCOL BENCHMARK COMMAND MIXES
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+// The poll mixes and the binary request frame of protocolbench.cpp. The host build benchmarks
+// (Test-Programs/HOSTBUILD) replay the same mixes against the simulated focuser.
+
+#ifndef protocolmixes_h
+#define protocolmixes_h
+
+#include <stdint.h>
+#include <vector>
+
+#define BINSYNC               0xA5          // binary frame layout, must match generalDefinitions.h
+#define BINHEADERSIZE         5
+#define BIN_NONE              0
+#define BIN_ERROR             7
+
+// opcodes a client sends in one poll cycle, taken from the drivers' poll loops
+struct mix_t
+{
+  const char *name;
+  std::vector<int> opcodes;
+};
+
+static const mix_t mixes[] =
+{
+  { "indi",   { 0, 1, 6, 39, 29, 11 } },        // position, ismoving, temperature, target, stepmode, coilpower
+  { "ascom",  { 1, 0, 6, 1, 0 } },              // ismoving and position polled twice per temperature read
+  { "apt",    { 0, 1, 6, 8, 24 } },             // position, ismoving, temperature, maxstep, tempcomp
+  { "status", { 85 } },                         // :85# composite status
+};
+
+// CRC-16/CCITT, poly 0x1021, start with 0xFFFF, same as crc16() in comms.h
+static inline uint16_t crc16(uint16_t crc, const uint8_t *data, int len)
+{
+  while ( len-- )
+  {
+    crc ^= (uint16_t) (*data++) << 8;
+    for ( int i = 0; i < 8; i++ )
+    {
+      crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+    }
+  }
+  return crc;
+}
+
+// BINSYNC opcode BIN_NONE 0 0 crc, a request without payload
+static inline void binaryframe(int opcode, uint8_t frame[BINHEADERSIZE + 2])
+{
+  frame[0] = BINSYNC;
+  frame[1] = (uint8_t) opcode;
+  frame[2] = BIN_NONE;
+  frame[3] = 0;
+  frame[4] = 0;
+  uint16_t crc = crc16(0xFFFF, frame + 1, BINHEADERSIZE - 1);
+  frame[BINHEADERSIZE] = crc & 0xFF;
+  frame[BINHEADERSIZE + 1] = crc >> 8;
+}
+
+#endif
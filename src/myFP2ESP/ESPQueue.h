@@ -1,107 +1,107 @@
 /*
  * Queue.h
  * By Steven de Salas
- * 
+ *
  * Defines a templated (generic) class for a queue of things.
  * Used for Arduino projects, just #include "Queue.h" and add this file via the IDE.
  */
- 
+
 // Modified by Robert Brown for use with ESP32, August 2019
 
+// Rewritten as a fixed size single producer / single consumer ring of command slots, no String and
+// no heap. The producer (serial or bluetooth reader) builds a frame in place in the head slot with
+// clearframe(), addframe() and pushframe(). The consumer (loop) reads the tail slot with peek() and
+// releases it with pop(). Each index is only written by one side, so the producer can run in a
+// receive callback or task while loop() consumes.
+
 #ifndef ESPQueue_H
 #define ESPQueue_H
 
-class Queue {
+#include <stdint.h>
+#include <string.h>
+
+template<int SLOTS, int SLOTSIZE> class Queue {
   private:
-    int _front, _back, _count;
-    String *_data;
-    int _maxitems;
+    char _data[SLOTS + 1][SLOTSIZE];            // one slot is always free so full and empty differ
+    volatile uint16_t _front;                   // next slot to read, written by the consumer only
+    volatile uint16_t _back;                    // slot being built, written by the producer only
+    uint16_t _len;                              // length of the frame being built
+    bool _drop;                                 // frame too long or queue full, drop it
+
+    inline uint16_t next(uint16_t i)
+    {
+      return (i == SLOTS) ? 0 : (i + 1);
+    }
+
   public:
-    Queue(int maxitems = 256) 
-    { 
+    Queue()
+    {
       _front = 0;
       _back = 0;
-      _count = 0;
-      _maxitems = maxitems;
-      _data = new String[maxitems + 1];   
+      _len = 0;
+      _drop = false;
     }
-    ~Queue() 
+
+    inline int count()
     {
-      delete[] _data;  
+      int n = (int) _back - (int) _front;
+      return (n < 0) ? (n + SLOTS + 1) : n;
     }
-    inline int count();
-    inline int front();
-    inline int back();
-    void push(const String &item);
-    String peek();
-    String pop();
-    void clear();
-};
 
-inline int Queue::count() 
-{
-  return _count;
-}
-
-inline int Queue::front() 
-{
-  return _front;
-}
+    // producer, start a new frame in the head slot
+    inline void clearframe()
+    {
+      _len = 0;
+      _drop = false;
+    }
 
-inline int Queue::back() 
-{
-  return _back;
-}
+    // producer, add a char to the frame, it is dropped if it does not fit or the queue is full
+    inline void addframe(char c)
+    {
+      if ( (_len < (SLOTSIZE - 1)) && (next(_back) != _front) )
+      {
+        _data[_back][_len++] = c;
+      }
+      else
+      {
+        _drop = true;
+      }
+    }
 
-void Queue::push(const String &item)
-{
-  if(_count < _maxitems) 
-  { 
-    // Drops out when full
-    _data[_back++]=item;
-    ++_count;
-    // Check wrap around
-    if (_back > _maxitems)
+    // producer, publish the frame to the consumer
+    void pushframe()
     {
-      _back -= (_maxitems + 1);
+      uint16_t n = next(_back);
+      if ( !_drop && (n != _front) )
+      {
+        _data[_back][_len] = 0;
+        __sync_synchronize();                   // slot contents visible before the index moves
+        _back = n;
+      }
+      clearframe();
     }
-  }
-}
 
-String Queue::pop() {
-  if(_count <= 0) 
-  {
-    return String(); // Returns empty
-  }
-  else 
-  {
-    String result = _data[_front];
-    _front++;
-    --_count;
-    // Check wrap around
-    if (_front > _maxitems) 
+    // consumer, oldest frame, only valid while count() > 0 and until pop()
+    inline const char *peek()
     {
-      _front -= (_maxitems + 1);
+      return _data[_front];
     }
-    return result; 
-  }
-}
 
-String Queue::peek() {
-  if(_count <= 0)
-  {
-    return String(); // Returns empty
-  }
-  else
-  {
-    return _data[_front];
-  }
-}
+    // consumer, release the oldest frame
+    void pop()
+    {
+      if ( _front != _back )
+      {
+        __sync_synchronize();                   // done with the slot before the producer can reuse it
+        _front = next(_front);
+      }
+    }
 
-void Queue::clear() 
-{
-  _front = _back;
-  _count = 0;
-}
+    // consumer, drop every waiting frame
+    void clear()
+    {
+      _front = _back;
+    }
+};
 
 #endif
@@ -11,14 +11,10 @@
 
 #include <ArduinoJson.h>
 
-#if defined(ESP8266)
-#include "FS.h"
-#else
-#include "SPIFFS.h"
-#endif
-
+#include "hal.h"
 #include "FocuserSetupData.h"
 #include "generalDefinitions.h"
+#include "crc16.h"
 
 // delay(10) required in ESP8266 code arounf file handling
 
@@ -26,15 +22,28 @@ SetupData::SetupData(void)
 {
   DebugPrintln("Constructor Setupdata");
 
-  this->SnapShotMillis = millis();
+  this->SnapShotMillis = halmillis();
   this->ReqSaveData_var  = false;
-  this->ReqSaveData_per = false;
+  this->ReqSaveData_per = 0;
+  this->journalseq = 0;
+  this->journalcount = 0;
+  for (int g = 0; g < PERSISTGROUPS; g++)
+  {
+    this->persistgen[g] = 0;
+    this->persistslot[g] = 1;
+  }
+  this->pendinggroups = 0;
+#if defined(ESP32)
+  this->persistlock = xSemaphoreCreateMutex();
+  this->pendinglock = portMUX_INITIALIZER_UNLOCKED;
+  this->savespaused = false;
+#endif
 
-  if (!SPIFFS.begin())
+  if (!HALFS.begin())
   {
     DebugPrintln(F("FS !mounted"));
     DebugPrintln(F("Formatting, please wait..."));
-    SPIFFS.format();
+    HALFS.format();
     DebugPrintln(F("Format FS done"));
   }
   else
@@ -43,6 +52,9 @@ SetupData::SetupData(void)
     this->ListDir("/", 0);
   }
   this->LoadConfiguration();
+#if defined(ESP32)
+  xTaskCreatePinnedToCore(savetask, "save", SAVETASKSTACKSIZE, this, SAVETASKPRIORITY, &this->savetaskhandle, SAVETASKCORE);
+#endif
 };
 
 // Loads the configuration from a file
@@ -50,84 +62,31 @@ byte SetupData::LoadConfiguration()
 {
   byte retval = 0;
 
-  // Open file for reading
-  File file = SPIFFS.open(filename_persistant, "r");
-  delay(10);
-
-  if (!file)
+  if ( !LoadPersistantImage() )
   {
-    DebugPrintln(F("no persistant data file, load default values"));
-    LoadDefaultPersistantData();
-    delay(10);
+    DebugPrintln(F("no persistant data file, default values saved"));
   }
-  else
+  // a json file is imported once, it comes from an older firmware or was uploaded to change the settings
+  // it is only removed once the imported settings are saved, a reset before that imports it again
+  if ( HALFS.exists(filename_persistant) )
   {
-    delay(10);
-    String data = file.readString();                  // read content of the text file
-    DebugPrint(F("FS. Persistant SetupData= "));
-    DebugPrintln(data);                               // ... and print on serial
-
-    // Allocate a temporary JsonDocument
-    DynamicJsonDocument doc_per(DEFAULTDOCSIZE);
-
-    // Deserialize the JSON document
-    DeserializationError error = deserializeJson(doc_per, data);
-    if (error)
-    {
-      DebugPrintln(F("Failed to read persistant data file, using default configuration"));
-      LoadDefaultPersistantData();
-    }
-    else
+    if ( !ImportConfiguration() || SavePersitantConfiguration(PERSISTALL) )
     {
-      this->maxstep               = doc_per["maxstep"];                   // max steps
-      this->stepsize              = doc_per["stepsize"];                  // the step size in microns, ie 7.2 - value * 10, so real stepsize = stepsize / 10 (maxval = 25.6)
-      this->DelayAfterMove        = doc_per["delayaftermove"];            // delay after movement is finished (maxval=256)
-      this->backlashsteps_in      = doc_per["backlashsteps_in"];          // number of backlash steps to apply for IN moves
-      this->backlashsteps_out     = doc_per["backlashsteps_out"];         // number of backlash steps to apply for OUT moves
-      this->backlash_in_enabled   = doc_per["backlash_in_enabled"];
-      this->backlash_out_enabled  = doc_per["backlash_out_enabled"];
-      this->tempcoefficient       = doc_per["tempcoefficient"];           // steps per degree temperature coefficient value (maxval=256)
-      this->tempresolution        = doc_per["tempresolution"];            // 9 -12
-      this->stepmode              = doc_per["stepmode"];
-      this->coilpower             = doc_per["coilpwr"];
-      this->reversedirection      = doc_per["rdirection"];
-      this->stepsizeenabled       = doc_per["stepsizestate"];             // if 1, controller returns step size
-      this->tempmode              = doc_per["tempmode"];                  // temperature display mode, Celcius=1, Fahrenheit=0
-      this->lcdupdateonmove       = doc_per["lcdupdateonmove"];           // update position on lcd when moving
-      this->lcdpagetime           = doc_per["lcdpagetime"];
-      this->tempcompenabled       = doc_per["tempcompstate"];             // indicates if temperature compensation is enabled
-      this->tcdirection           = doc_per["tcdir"];
-      this->motorSpeed            = doc_per["motorspeed"];
-      this->displayenabled        = doc_per["displaystate"];
-      for (int i = 0; i < 10; i++)
-      {
-        this->preset[i]           = doc_per["preset"][i];
-      }
-      this->webserverport         = doc_per["wsport"];
-      this->ascomalpacaport       = doc_per["ascomport"];
-      this->webpagerefreshrate    = doc_per["wprefreshrate"];
-      this->mdnsport              = doc_per["mdnsport"];
-      this->tcpipport             = doc_per["tcpipport"];
-      this->startscreen           = doc_per["startscrn"];
-      this->backcolor             = doc_per["bcol"].as<char*>();
-      this->textcolor             = doc_per["tcol"].as<char*>();
-      this->headercolor           = doc_per["hcol"].as<char*>();
-      this->titlecolor            = doc_per["ticol"].as<char*>();
-      this->ascomserverstate      = doc_per["ason"];
-      this->webserverstate        = doc_per["wson"];
-      this->temperatureprobestate = doc_per["tprobe"];
-      this->inoutledstate         = doc_per["leds"];
-      this->showhpswmessages      = doc_per["hpswmsg"];
-      this->forcedownload         = doc_per["fcdownld"];
-      this->oledpageoption        = doc_per["oledpg"].as<char*>();
-      this->motorspeeddelay       = doc_per["msdelay"];
-      this->homepositionswitch    = doc_per["hpsw"];
+      HALFS.remove(filename_persistant);
     }
-    file.close();
-    DebugPrintln(F("config file persistant data loaded"));
   }
-  delay(10);
-  file = SPIFFS.open(filename_variable, "r");
+  haldelay(10);
+  if ( LoadJournal() )
+  {
+    DebugPrintln(F("position journal loaded"));
+    // round position to fullstep motor position
+    this->fposition = (this->fposition + this->stepmode / 2) / this->stepmode * this->stepmode;
+    this->savedposition = this->fposition;
+    this->saveddirection = this->focuserdirection;
+    return 3;
+  }
+  // no journal yet, the position is in the variable data file of an older firmware
+  halfile_t file = HALFS.open(filename_variable, "r");
   if (!file)
   {
     DebugPrintln(F("file variable data !found, load default values"));
@@ -163,22 +122,421 @@ byte SetupData::LoadConfiguration()
   }
   file.close();
   DebugPrintln(F("config file variable data loaded"));
+  this->savedposition = this->fposition;
+  this->saveddirection = this->focuserdirection;
   return retval;
 }
 
+// read the settings from the json file, used to import settings, returns false if it cannot be read
+boolean SetupData::ImportConfiguration()
+{
+  halfile_t file = HALFS.open(filename_persistant, "r");
+  if (!file)
+  {
+    return false;
+  }
+  String data = file.readString();                    // read content of the text file
+  file.close();
+  DebugPrint(F("FS. Persistant SetupData= "));
+  DebugPrintln(data);                                 // ... and print on serial
+
+  // Allocate a temporary JsonDocument
+  DynamicJsonDocument doc_per(DEFAULTDOCSIZE);
+
+  // Deserialize the JSON document
+  DeserializationError error = deserializeJson(doc_per, data);
+  if (error)
+  {
+    DebugPrintln(F("Failed to read persistant data file"));
+    return false;
+  }
+    this->maxstep               = doc_per["maxstep"];                   // max steps
+    this->stepsize              = doc_per["stepsize"];                  // the step size in microns, ie 7.2 - value * 10, so real stepsize = stepsize / 10 (maxval = 25.6)
+    this->DelayAfterMove        = doc_per["delayaftermove"];            // delay after movement is finished (maxval=256)
+    this->backlashsteps_in      = doc_per["backlashsteps_in"];          // number of backlash steps to apply for IN moves
+    this->backlashsteps_out     = doc_per["backlashsteps_out"];         // number of backlash steps to apply for OUT moves
+    this->backlash_in_enabled   = doc_per["backlash_in_enabled"];
+    this->backlash_out_enabled  = doc_per["backlash_out_enabled"];
+    this->tempcoefficient       = doc_per["tempcoefficient"];           // steps per degree temperature coefficient value (maxval=256)
+    this->tempresolution        = doc_per["tempresolution"];            // 9 -12
+    this->stepmode              = doc_per["stepmode"];
+    this->coilpower             = doc_per["coilpwr"];
+    this->reversedirection      = doc_per["rdirection"];
+    this->stepsizeenabled       = doc_per["stepsizestate"];             // if 1, controller returns step size
+    this->tempmode              = doc_per["tempmode"];                  // temperature display mode, Celcius=1, Fahrenheit=0
+    this->lcdupdateonmove       = doc_per["lcdupdateonmove"];           // update position on lcd when moving
+    this->lcdpagetime           = doc_per["lcdpagetime"];
+    this->tempcompenabled       = doc_per["tempcompstate"];             // indicates if temperature compensation is enabled
+    this->tcdirection           = doc_per["tcdir"];
+    this->motorSpeed            = doc_per["motorspeed"];
+    this->displayenabled        = doc_per["displaystate"];
+    for (int i = 0; i < 10; i++)
+    {
+      this->preset[i]           = doc_per["preset"][i];
+    }
+    this->webserverport         = doc_per["wsport"];
+    this->ascomalpacaport       = doc_per["ascomport"];
+    this->webpagerefreshrate    = doc_per["wprefreshrate"];
+    this->mdnsport              = doc_per["mdnsport"];
+    this->tcpipport             = doc_per["tcpipport"];
+    this->startscreen           = doc_per["startscrn"];
+    this->backcolor             = doc_per["bcol"].as<char*>();
+    this->textcolor             = doc_per["tcol"].as<char*>();
+    this->headercolor           = doc_per["hcol"].as<char*>();
+    this->titlecolor            = doc_per["ticol"].as<char*>();
+    this->ascomserverstate      = doc_per["ason"];
+    this->webserverstate        = doc_per["wson"];
+    this->temperatureprobestate = doc_per["tprobe"];
+    this->inoutledstate         = doc_per["leds"];
+    this->showhpswmessages      = doc_per["hpswmsg"];
+    this->forcedownload         = doc_per["fcdownld"];
+    this->oledpageoption        = doc_per["oledpg"].as<char*>();
+    this->motorspeeddelay       = doc_per["msdelay"];
+    this->homepositionswitch    = doc_per["hpsw"];
+    this->motoraccel            = doc_per["maccel"];
+    this->maxspeeddelay         = doc_per["mxsdelay"];
+  DebugPrintln(F("config file persistant data imported"));
+  return true;
+}
+
+// offset and size of each group in persistdata_t, in PERSIST bit order
+static const struct
+{
+  uint16_t offset;
+  uint16_t size;
+} persistgroups[PERSISTGROUPS] =
+{
+  { offsetof(persistdata_t, motor),    sizeof(persistmotor_t) },
+  { offsetof(persistdata_t, backlash), sizeof(persistbacklash_t) },
+  { offsetof(persistdata_t, temp),     sizeof(persisttemp_t) },
+  { offsetof(persistdata_t, display),  sizeof(persistdisplay_t) },
+  { offsetof(persistdata_t, presets),  sizeof(persistpresets_t) },
+  { offsetof(persistdata_t, network),  sizeof(persistnetwork_t) },
+  { offsetof(persistdata_t, colors),   sizeof(persistcolors_t) },
+};
+
+void SetupData::PersistantFilename(char *name, int group, int slot)
+{
+  snprintf(name, 16, "/data_per%d%c.bin", group, 'a' + slot);
+}
+
+static uint16_t persistcrc(const persistheader_t &hdr, const uint8_t *data)
+{
+  return crc16(crc16(0xFFFF, (const uint8_t *) &hdr.generation, sizeof(hdr.generation)), data, hdr.size);
+}
+
+// read the binary settings, the newest valid slot of each group, returns false if no group was found
+// a group with no valid slot keeps its defaults, a group from an older version is shorter and the
+// fields it does not have keep their defaults, those groups are written back
+boolean SetupData::LoadPersistantImage()
+{
+  persistheader_t hdr;
+  persistdata_t img;
+  persistdata_t def;
+  char name[16];
+  byte found = 0;
+  byte rewrite = 0;
+
+  LoadDefaultPersistantData();
+  PackPersistant(def);
+  img = def;
+  for (int g = 0; g < PERSISTGROUPS; g++)
+  {
+    uint8_t *data = (uint8_t *) &img + persistgroups[g].offset;
+    uint8_t buf[sizeof(persistdata_t)];
+    this->persistgen[g] = 0;
+    this->persistslot[g] = 1;
+    for (int slot = 0; slot < 2; slot++)
+    {
+      PersistantFilename(name, g, slot);
+      halfile_t file = HALFS.open(name, "r");
+      if (!file)
+      {
+        continue;
+      }
+      boolean ok = (file.read((uint8_t *) &hdr, sizeof(hdr)) == sizeof(hdr)) && (hdr.magic == PERSISTMAGIC)
+                   && (hdr.version <= PERSISTVERSION) && (hdr.size <= persistgroups[g].size)
+                   && (file.read(buf, hdr.size) == hdr.size) && (hdr.crc == persistcrc(hdr, buf));
+      file.close();
+      if ( !ok )
+      {
+        DebugPrint(name);
+        DebugPrintln(F(" damaged"));
+        continue;
+      }
+      if ( (found & (1 << g)) && ((int32_t) (hdr.generation - this->persistgen[g]) <= 0) )
+      {
+        continue;                                     // the other slot is newer
+      }
+      memcpy(data, (const uint8_t *) &def + persistgroups[g].offset, persistgroups[g].size);
+      memcpy(data, buf, hdr.size);
+      found |= (1 << g);
+      this->persistgen[g] = hdr.generation;
+      this->persistslot[g] = slot;
+      if ( hdr.size < persistgroups[g].size )
+      {
+        rewrite |= (1 << g);                          // upgrade the group to this version
+      }
+      else
+      {
+        rewrite &= ~(1 << g);
+      }
+    }
+    if ( (found & (1 << g)) == 0 )
+    {
+      rewrite |= (1 << g);
+    }
+  }
+  UnpackPersistant(img);
+  if ( rewrite )
+  {
+    SavePersitantConfiguration(rewrite);
+  }
+  DebugPrintln(F("persistant data loaded"));
+  return (found != 0);
+}
+
+// copy the settings into an image, unused bytes are zero so the crc only depends on the values
+void SetupData::PackPersistant(persistdata_t &img)
+{
+  memset(&img, 0, sizeof(img));
+  img.motor.maxstep                    = this->maxstep;
+  img.motor.stepsize                   = this->stepsize;
+  img.motor.DelayAfterMove             = this->DelayAfterMove;
+  img.motor.stepmode                   = this->stepmode;
+  img.motor.coilpower                  = this->coilpower;
+  img.motor.reversedirection           = this->reversedirection;
+  img.motor.stepsizeenabled            = this->stepsizeenabled;
+  img.motor.motorSpeed                 = this->motorSpeed;
+  img.motor.motorspeeddelay            = this->motorspeeddelay;
+  img.motor.homepositionswitch         = this->homepositionswitch;
+  img.motor.motoraccel                 = this->motoraccel;
+  img.motor.maxspeeddelay              = this->maxspeeddelay;
+  img.backlash.backlashsteps_in        = this->backlashsteps_in;
+  img.backlash.backlashsteps_out       = this->backlashsteps_out;
+  img.backlash.backlash_in_enabled     = this->backlash_in_enabled;
+  img.backlash.backlash_out_enabled    = this->backlash_out_enabled;
+  img.temp.tempcoefficient             = this->tempcoefficient;
+  img.temp.tempresolution              = this->tempresolution;
+  img.temp.tempmode                    = this->tempmode;
+  img.temp.tempcompenabled             = this->tempcompenabled;
+  img.temp.tcdirection                 = this->tcdirection;
+  img.temp.temperatureprobestate       = this->temperatureprobestate;
+  img.display.lcdupdateonmove          = this->lcdupdateonmove;
+  img.display.lcdpagetime              = this->lcdpagetime;
+  img.display.displayenabled           = this->displayenabled;
+  img.display.startscreen              = this->startscreen;
+  img.display.showhpswmessages         = this->showhpswmessages;
+  img.display.inoutledstate            = this->inoutledstate;
+  strncpy(img.display.oledpageoption, this->oledpageoption.c_str(), sizeof(img.display.oledpageoption) - 1);
+  for (int i = 0; i < 10; i++)
+  {
+    img.presets.preset[i]              = this->preset[i];
+  }
+  img.network.webserverport            = this->webserverport;
+  img.network.ascomalpacaport          = this->ascomalpacaport;
+  img.network.webpagerefreshrate       = this->webpagerefreshrate;
+  img.network.mdnsport                 = this->mdnsport;
+  img.network.tcpipport                = this->tcpipport;
+  img.network.ascomserverstate         = this->ascomserverstate;
+  img.network.webserverstate           = this->webserverstate;
+  img.network.forcedownload            = this->forcedownload;
+  strncpy(img.colors.backcolor, this->backcolor.c_str(), sizeof(img.colors.backcolor) - 1);
+  strncpy(img.colors.textcolor, this->textcolor.c_str(), sizeof(img.colors.textcolor) - 1);
+  strncpy(img.colors.headercolor, this->headercolor.c_str(), sizeof(img.colors.headercolor) - 1);
+  strncpy(img.colors.titlecolor, this->titlecolor.c_str(), sizeof(img.colors.titlecolor) - 1);
+}
+
+void SetupData::UnpackPersistant(persistdata_t &img)
+{
+  this->maxstep                        = img.motor.maxstep;
+  this->stepsize                       = img.motor.stepsize;
+  this->DelayAfterMove                 = img.motor.DelayAfterMove;
+  this->stepmode                       = img.motor.stepmode;
+  this->coilpower                      = img.motor.coilpower;
+  this->reversedirection               = img.motor.reversedirection;
+  this->stepsizeenabled                = img.motor.stepsizeenabled;
+  this->motorSpeed                     = img.motor.motorSpeed;
+  this->motorspeeddelay                = img.motor.motorspeeddelay;
+  this->homepositionswitch             = img.motor.homepositionswitch;
+  this->motoraccel                     = img.motor.motoraccel;
+  this->maxspeeddelay                  = img.motor.maxspeeddelay;
+  this->backlashsteps_in               = img.backlash.backlashsteps_in;
+  this->backlashsteps_out              = img.backlash.backlashsteps_out;
+  this->backlash_in_enabled            = img.backlash.backlash_in_enabled;
+  this->backlash_out_enabled           = img.backlash.backlash_out_enabled;
+  this->tempcoefficient                = img.temp.tempcoefficient;
+  this->tempresolution                 = img.temp.tempresolution;
+  this->tempmode                       = img.temp.tempmode;
+  this->tempcompenabled                = img.temp.tempcompenabled;
+  this->tcdirection                    = img.temp.tcdirection;
+  this->temperatureprobestate          = img.temp.temperatureprobestate;
+  this->lcdupdateonmove                = img.display.lcdupdateonmove;
+  this->lcdpagetime                    = img.display.lcdpagetime;
+  this->displayenabled                 = img.display.displayenabled;
+  this->startscreen                    = img.display.startscreen;
+  this->showhpswmessages               = img.display.showhpswmessages;
+  this->inoutledstate                  = img.display.inoutledstate;
+  for (int i = 0; i < 10; i++)
+  {
+    this->preset[i]                    = img.presets.preset[i];
+  }
+  this->webserverport                  = img.network.webserverport;
+  this->ascomalpacaport                = img.network.ascomalpacaport;
+  this->webpagerefreshrate             = img.network.webpagerefreshrate;
+  this->mdnsport                       = img.network.mdnsport;
+  this->tcpipport                      = img.network.tcpipport;
+  this->ascomserverstate               = img.network.ascomserverstate;
+  this->webserverstate                 = img.network.webserverstate;
+  this->forcedownload                  = img.network.forcedownload;
+  img.display.oledpageoption[sizeof(img.display.oledpageoption) - 1] = 0;
+  img.colors.backcolor[sizeof(img.colors.backcolor) - 1] = 0;
+  img.colors.textcolor[sizeof(img.colors.textcolor) - 1] = 0;
+  img.colors.headercolor[sizeof(img.colors.headercolor) - 1] = 0;
+  img.colors.titlecolor[sizeof(img.colors.titlecolor) - 1] = 0;
+  this->oledpageoption                 = img.display.oledpageoption;
+  this->backcolor                      = img.colors.backcolor;
+  this->textcolor                      = img.colors.textcolor;
+  this->headercolor                    = img.colors.headercolor;
+  this->titlecolor                     = img.colors.titlecolor;
+}
+
+// replay the position journal, the record with the highest seq and a good crc wins
+// returns true if a record was found
+boolean SetupData::LoadJournal()
+{
+  const String *names[2] = { &filename_journal, &filename_journalnew };
+  boolean found = false;
+  boolean compacting = false;
+  boolean damaged = false;
+  posrecord_t rec;
+
+  for (int i = 0; i < 2; i++)
+  {
+    halfile_t file = HALFS.open(*names[i], "r");
+    if (!file)
+    {
+      continue;
+    }
+    int count = 0;
+    while ( file.read((uint8_t *) &rec, sizeof(rec)) == sizeof(rec) )
+    {
+      count++;
+      if ( rec.crc != crc16(0xFFFF, (const uint8_t *) &rec, offsetof(posrecord_t, crc)) )
+      {
+        damaged = true;
+      }
+      else if ( !found || (rec.seq > this->journalseq) )
+      {
+        found = true;
+        this->journalseq = rec.seq;
+        this->fposition = rec.position;
+        this->focuserdirection = rec.direction;
+      }
+    }
+    if ( (file.size() % sizeof(rec)) != 0 )
+    {
+      damaged = true;                           // torn last record, the next append would not line up
+    }
+    file.close();
+    if ( i == 0 )
+    {
+      this->journalcount = count;
+    }
+    else
+    {
+      compacting = true;
+    }
+  }
+  if ( compacting || damaged )
+  {
+    // power was lost while compacting or appending, start a clean journal from the record found
+    // before anything is appended to the damaged one
+    HALFS.remove(filename_journalnew);
+    if ( found )
+    {
+      CompactJournal();
+    }
+    else
+    {
+      HALFS.remove(filename_journal);
+      this->journalcount = 0;
+    }
+  }
+  return found;
+}
+
+// append the current position and direction, the caller has opened the journal file
+boolean SetupData::WriteJournalRecord(halfile_t &file)
+{
+  posrecord_t rec;
+  rec.seq = this->journalseq + 1;
+  rec.position = this->fposition;
+  rec.direction = this->focuserdirection;
+  rec.reserved = 0;
+  rec.crc = crc16(0xFFFF, (const uint8_t *) &rec, offsetof(posrecord_t, crc));
+  if ( file.write((const uint8_t *) &rec, sizeof(rec)) != sizeof(rec) )
+  {
+    return false;
+  }
+  this->journalseq = rec.seq;
+  this->savedposition = rec.position;
+  this->saveddirection = rec.direction;
+  return true;
+}
+
+// journal is full, write the current record to a new file and swap it in
+boolean SetupData::CompactJournal()
+{
+  halfile_t file = HALFS.open(filename_journalnew, "w");
+  if (!file)
+  {
+    TRACE();
+    DebugPrintln(CREATEFILEFAILSTR);
+    return false;
+  }
+  boolean ok = WriteJournalRecord(file);
+  file.close();
+  if ( !ok )
+  {
+    HALFS.remove(filename_journalnew);
+    return false;
+  }
+  HALFS.remove(filename_journal);
+  HALFS.rename(filename_journalnew, filename_journal);
+  this->journalcount = 1;
+  DebugPrintln(F("position journal compacted"));
+  return true;
+}
+
+void SetupData::RemoveJournal()
+{
+  if ( HALFS.exists(filename_journal))
+  {
+    HALFS.remove(filename_journal);
+  }
+  if ( HALFS.exists(filename_journalnew))
+  {
+    HALFS.remove(filename_journalnew);
+  }
+  this->journalcount = 0;
+}
+
 void SetupData::SetFocuserDefaults(void)
 {
   LoadDefaultPersistantData();
+  SavePersitantConfiguration(PERSISTALL);
   LoadDefaultVariableData();
-  if ( SPIFFS.exists(filename_persistant))
+  if ( HALFS.exists(filename_persistant))
   {
-    SPIFFS.remove(filename_persistant);
+    HALFS.remove(filename_persistant);
   }
-  delay(10);
-  if ( SPIFFS.exists(filename_variable))
+  haldelay(10);
+  if ( HALFS.exists(filename_variable))
   {
-    SPIFFS.remove(filename_variable);
+    HALFS.remove(filename_variable);
   }
+  RemoveJournal();
 }
 
 void SetupData::LoadDefaultPersistantData()
@@ -226,7 +584,8 @@ void SetupData::LoadDefaultPersistantData()
   this->oledpageoption        = OLEDPGOPTIONALL;
   this->motorspeeddelay       = 0;                    // needs to come from driverboard
   this->homepositionswitch    = 0;
-  this->SavePersitantConfiguration();                 // write default values to SPIFFS
+  this->motoraccel            = DEFAULTOFF;           // no acceleration ramp
+  this->maxspeeddelay         = 0;                    // needs to come from driverboard
 }
 
 void SetupData::LoadDefaultVariableData()
@@ -239,47 +598,39 @@ void SetupData::LoadDefaultVariableData()
 boolean SetupData::SaveConfiguration(unsigned long currentPosition, byte DirOfTravel)
 {
   //Serial.println("SaveConfiguration:");
-  if (this->fposition != currentPosition || this->focuserdirection != DirOfTravel)  // last focuser position
+#if !defined(ESP32)
+  if ( this->pendinggroups != 0 )
+  {
+    WritePendingGroup();                              // a save is in progress, one group per call
+  }
+#endif
+  // the position is journalled as soon as the focuser stops, a record append is cheap
+  if (this->savedposition != currentPosition || this->saveddirection != DirOfTravel)  // last focuser position
   {
     this->fposition = currentPosition;
     this->focuserdirection = DirOfTravel;
+    if (SaveVariableConfiguration() == false)
+    {
+      DebugPrintln(F("Error save variable configuration"));
+    }
     this->ReqSaveData_var = true;
-    this->SnapShotMillis = millis();
-    DebugPrintln(F("++ request for saving variable data"));
-    delay(10);
+    this->SnapShotMillis = halmillis();
   }
 
   byte status = false;
-  unsigned long x = millis();
+  unsigned long x = halmillis();
 
   if ((SnapShotMillis + DEFAULTSAVETIME) < x || SnapShotMillis > x)    // 30s after snapshot
   {
-    if (this->ReqSaveData_per == true)
+    if (this->ReqSaveData_per != 0)
     {
-      if (SavePersitantConfiguration() == false)
-      {
-        DebugPrintln(F("Error save persistant configuration"));
-      }
-      else
-      {
-        delay(10);
-        DebugPrintln(F("++ persistant data saved"));
-      }
+      StartPersistantSave(this->ReqSaveData_per);     // written in the background
       status = true;
-      this->ReqSaveData_per = false;
+      this->ReqSaveData_per = 0;
     }
 
-    if (this->ReqSaveData_var == true)
+    if (this->ReqSaveData_var == true)                 // position already journalled, report it saved as before
     {
-      if (SaveVariableConfiguration() == false)
-      {
-        DebugPrintln(F("Error save variable configuration"));
-      }
-      else
-      {
-        delay(10);
-        DebugPrintln(F("++ variable data saved"));
-      }
       status = true;
       this->ReqSaveData_var = false;
     }
@@ -289,29 +640,186 @@ boolean SetupData::SaveConfiguration(unsigned long currentPosition, byte DirOfTr
 
 boolean SetupData::SaveNow()                                // used by reboot to save settings
 {
-  return SavePersitantConfiguration();
+  byte groups = this->ReqSaveData_per;
+  this->ReqSaveData_per = 0;
+#if defined(ESP32)
+  if ( this->savespaused == true )
+  {
+    StartPersistantSave(groups);                            // no flash writes during a move, written by ResumeSaves()
+    return true;
+  }
+#endif
+  return SavePersitantConfiguration(groups);
+}
+
+// a flash write disables the cache, the motor timer isr and the code it calls are not all in iram so
+// they must not run during one. called before a move starts, waits for a write in progress to finish
+void SetupData::PauseSaves()
+{
+#if defined(ESP32)
+  xSemaphoreTake(this->persistlock, portMAX_DELAY);
+  this->savespaused = true;
+  xSemaphoreGive(this->persistlock);
+#endif
+}
+
+// called once the move has finished, hands any save requested during the move to savetask
+void SetupData::ResumeSaves()
+{
+#if defined(ESP32)
+  xSemaphoreTake(this->persistlock, portMAX_DELAY);
+  this->savespaused = false;
+  xSemaphoreGive(this->persistlock);
+  if ( this->pendinggroups != 0 )
+  {
+    xTaskNotifyGive(this->savetaskhandle);
+  }
+#endif
+}
+
+// write the groups set in the bitmap now, the others are already on flash
+// groups still waiting for the background writer are written too, from the current settings
+byte SetupData::SavePersitantConfiguration(byte groups)
+{
+  persistdata_t img;
+  byte status = true;
+
+#if defined(ESP32)
+  xSemaphoreTake(this->persistlock, portMAX_DELAY);
+  portENTER_CRITICAL(&this->pendinglock);
+#endif
+  groups |= this->pendinggroups;
+  this->pendinggroups = 0;
+#if defined(ESP32)
+  portEXIT_CRITICAL(&this->pendinglock);
+#endif
+  PackPersistant(img);
+  for (int g = 0; g < PERSISTGROUPS; g++)
+  {
+    if ( (groups & (1 << g)) && !WritePersistantGroup(g, img) )
+    {
+      status = false;
+    }
+  }
+#if defined(ESP32)
+  xSemaphoreGive(this->persistlock);
+#endif
+  return status;
 }
 
-byte SetupData::SavePersitantConfiguration()
+// take a snapshot of the settings and hand the groups to the background writer
+void SetupData::StartPersistantSave(byte groups)
+{
+  persistdata_t img;
+
+  PackPersistant(img);
+#if defined(ESP32)
+  portENTER_CRITICAL(&this->pendinglock);
+  memcpy(&this->pendingimg, &img, sizeof(img));
+  this->pendinggroups |= groups;
+  portEXIT_CRITICAL(&this->pendinglock);
+  xTaskNotifyGive(this->savetaskhandle);
+#else
+  this->pendingimg = img;
+  this->pendinggroups |= groups;
+#endif
+  DebugPrintln(F("++ persistant data save started"));
+}
+
+#if defined(ESP32)
+// save task, writes the snapshot left by StartPersistantSave() so loop() and the servers are not held up
+void SetupData::savetask(void *arg)
+{
+  SetupData *sd = (SetupData *) arg;
+  persistdata_t img;
+
+  for (;;)
+  {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    xSemaphoreTake(sd->persistlock, portMAX_DELAY);
+    if ( sd->savespaused == true )
+    {
+      xSemaphoreGive(sd->persistlock);                // motor moving, groups stay pending till ResumeSaves()
+      continue;
+    }
+    portENTER_CRITICAL(&sd->pendinglock);
+    memcpy(&img, &sd->pendingimg, sizeof(img));
+    byte groups = sd->pendinggroups;
+    sd->pendinggroups = 0;
+    portEXIT_CRITICAL(&sd->pendinglock);
+    for (int g = 0; g < PERSISTGROUPS; g++)
+    {
+      if ( (groups & (1 << g)) && !sd->WritePersistantGroup(g, img) )
+      {
+        DebugPrintln(F("Error save persistant configuration"));
+      }
+    }
+    xSemaphoreGive(sd->persistlock);
+  }
+}
+#else
+// write the lowest pending group, each call is one short file write so loop() keeps serving clients
+void SetupData::WritePendingGroup()
 {
-  delay(10);
-  if ( SPIFFS.exists(filename_persistant))
+  for (int g = 0; g < PERSISTGROUPS; g++)
   {
-    SPIFFS.remove(filename_persistant);
+    if ( this->pendinggroups & (1 << g) )
+    {
+      this->pendinggroups &= ~(1 << g);
+      if ( !WritePersistantGroup(g, this->pendingimg) )
+      {
+        DebugPrintln(F("Error save persistant configuration"));
+      }
+      return;
+    }
   }
-  delay(10);
-  File file = SPIFFS.open(filename_persistant, "w");         // Open file for writing
+}
+#endif
+
+// write one group to its older slot with the next generation, the newer slot stays valid until then
+boolean SetupData::WritePersistantGroup(int g, const persistdata_t &img)
+{
+  persistheader_t hdr;
+  char name[16];
+  const uint8_t *data = (const uint8_t *) &img + persistgroups[g].offset;
+  int slot = this->persistslot[g] ^ 1;
+
+  hdr.magic = PERSISTMAGIC;
+  hdr.version = PERSISTVERSION;
+  hdr.generation = this->persistgen[g] + 1;
+  hdr.size = persistgroups[g].size;
+  hdr.crc = persistcrc(hdr, data);
+
+  PersistantFilename(name, g, slot);
+  halfile_t file = HALFS.open(name, "w");             // Open file for writing
   if (!file)
   {
     TRACE();
     DebugPrintln(CREATEFILEFAILSTR);
     return false;
   }
+  boolean ok = (file.write((const uint8_t *) &hdr, sizeof(hdr)) == sizeof(hdr))
+               && (file.write(data, hdr.size) == hdr.size);
+  file.close();                                       // Close the file
+  if ( !ok )
+  {
+    TRACE();
+    DebugPrintln(WRITEFILEFAILSTR);
+    return false;
+  }
+  this->persistgen[g] = hdr.generation;               // the next save overwrites the other slot
+  this->persistslot[g] = slot;
+  DebugPrint(name);
+  DebugPrint(" ");
+  DebugPrintln(WRITEFILESUCCESSSTR);
+  return true;
+}
 
-  // Allocate a temporary JsonDocument
-  // Don't forget to change the capacity to match your requirements.
-  // Use arduinojson.org/assistant to compute the capacity.
-  StaticJsonDocument<DEFAULTDOCSIZE> doc;
+// the settings as a json document, same keys as the data_per.jsn file that ImportConfiguration() reads
+String SetupData::ExportConfiguration()
+{
+  // Allocate a temporary JsonDocument, on the heap as this is only used for an export
+  DynamicJsonDocument doc(DEFAULTDOCSIZE);
 
   // Set the values in the document
   doc["maxstep"]            = this->maxstep;                    // max steps
@@ -357,66 +865,39 @@ byte SetupData::SavePersitantConfiguration()
   doc["oledpg"]             = this->oledpageoption;
   doc["msdelay"]            = this->motorspeeddelay;
   doc["hpsw"]               = this->homepositionswitch;
-  
-  // Serialize JSON to file
-  DebugPrintln("Writing to file");
-  if (serializeJson(doc, file) == 0)
-  {
-    TRACE();
-    DebugPrintln(WRITEFILEFAILSTR);
-    file.close();                                     // Close the file
-    return false;
-  }
-  else
-  {
-    DebugPrintln(WRITEFILESUCCESSSTR);
-    file.close();                                     // Close the file
-    return true;
-  }
+  doc["maccel"]             = this->motoraccel;
+  doc["mxsdelay"]           = this->maxspeeddelay;
+
+  String jsonstr;
+  serializeJson(doc, jsonstr);
+  return jsonstr;
 }
 
+// append the position to the journal, compact it when it is full
 byte SetupData::SaveVariableConfiguration()
 {
-  // Delete existing file
-  if ( SPIFFS.exists(filename_variable))
+  if ( this->journalcount >= POSJOURNALRECORDS )
   {
-    SPIFFS.remove(filename_variable);
+    return CompactJournal();
   }
-  delay(10);
-  SPIFFS.remove(filename_variable);
-
-  delay(10);
-  // Open file for writing
-  File file = SPIFFS.open(this->filename_variable, "w");
+  halfile_t file = HALFS.open(this->filename_journal, "a");
   if (!file)
   {
     TRACE();
     DebugPrintln(CREATEFILEFAILSTR);
     return false;
   }
-
-  // Allocate a temporary JsonDocument
-  // Don't forget to change the capacity to match your requirements.
-  // Use arduinojson.org/assistant to compute the capacity.
-  StaticJsonDocument<DEFAULTVARDOCSIZE> doc;
-
-  // Set the values in the document
-  doc["fpos"] =  this->fposition;                  // last focuser position
-  doc["fdir"] =  this->focuserdirection;           // keeps track of last focuser move direction
-
-  if (serializeJson(doc, file) == 0)                // Serialize JSON to file
+  boolean ok = WriteJournalRecord(file);
+  file.close();
+  if ( !ok )
   {
     TRACE();
     DebugPrintln(WRITEFILEFAILSTR);
-    file.close();                                   // Close the file
     return false;
   }
-  else
-  {
-    DebugPrintln(WRITEFILESUCCESSSTR);
-    file.close();     // Close the file
-    return true;
-  }
+  this->journalcount++;
+  DebugPrintln(F("++ position journalled"));
+  return true;
 }
 
 //__getter
@@ -633,6 +1114,16 @@ int SetupData::get_homepositionswitch()
   return this->homepositionswitch;
 }
 
+int SetupData::get_motoraccel()
+{
+  return this->motoraccel;
+}
+
+int SetupData::get_maxspeeddelay()
+{
+  return this->maxspeeddelay;
+}
+
 //__Setter
 
 void SetupData::set_fposition(unsigned long fposition)
@@ -647,254 +1138,264 @@ void SetupData::set_focuserdirection(byte focuserdirection)
 
 void SetupData::set_maxstep(unsigned long maxstep)
 {
-  this->StartDelayedUpdate(this->maxstep, maxstep); // max steps
+  this->StartDelayedUpdate(this->maxstep, maxstep, PERSISTMOTOR); // max steps
 }
 
 void SetupData::set_stepsize(float stepsize)
 {
-  this->StartDelayedUpdate(this->stepsize, stepsize); // the step size in microns, ie 7.2 - value * 10, so real stepsize = stepsize / 10 (maxval = 25.6)
+  this->StartDelayedUpdate(this->stepsize, stepsize, PERSISTMOTOR); // the step size in microns, ie 7.2 - value * 10, so real stepsize = stepsize / 10 (maxval = 25.6)
 }
 
 void SetupData::set_DelayAfterMove(byte DelayAfterMove)
 {
-  this->StartDelayedUpdate(this->DelayAfterMove, DelayAfterMove); // delay after movement is finished (maxval=256)
+  this->StartDelayedUpdate(this->DelayAfterMove, DelayAfterMove, PERSISTMOTOR); // delay after movement is finished (maxval=256)
 }
 
 void SetupData::set_backlashsteps_in(byte backlashsteps)
 {
-  this->StartDelayedUpdate(this->backlashsteps_in, backlashsteps); // number of backlash steps to apply for IN moves
+  this->StartDelayedUpdate(this->backlashsteps_in, backlashsteps, PERSISTBACKLASH); // number of backlash steps to apply for IN moves
 }
 
 void SetupData::set_backlashsteps_out(byte backlashsteps_out)
 {
-  this->StartDelayedUpdate(this->backlashsteps_out, backlashsteps_out); // number of backlash steps to apply for OUT moves
+  this->StartDelayedUpdate(this->backlashsteps_out, backlashsteps_out, PERSISTBACKLASH); // number of backlash steps to apply for OUT moves
 }
 
 void SetupData::set_backlash_in_enabled(byte backlash_in_enabled)
 {
-  this->StartDelayedUpdate(this->backlash_in_enabled, backlash_in_enabled);
+  this->StartDelayedUpdate(this->backlash_in_enabled, backlash_in_enabled, PERSISTBACKLASH);
 }
 
 void SetupData::set_backlash_out_enabled(byte backlash_out_enabled)
 {
-  this->StartDelayedUpdate(this->backlash_out_enabled, backlash_out_enabled);
+  this->StartDelayedUpdate(this->backlash_out_enabled, backlash_out_enabled, PERSISTBACKLASH);
 }
 
 void SetupData::set_tempcoefficient(byte tempcoefficient)
 {
-  this->StartDelayedUpdate(this->tempcoefficient, tempcoefficient); // steps per degree temperature coefficient value (maxval=256)
+  this->StartDelayedUpdate(this->tempcoefficient, tempcoefficient, PERSISTTEMP); // steps per degree temperature coefficient value (maxval=256)
 }
 
 void SetupData::set_tempresolution(byte tempresolution)
 {
-  this->StartDelayedUpdate(this->tempresolution, tempresolution);
+  this->StartDelayedUpdate(this->tempresolution, tempresolution, PERSISTTEMP);
 }
 
 void SetupData::set_stepmode(int stepmode)
 {
-  this->StartDelayedUpdate(this->stepmode, stepmode);
+  this->StartDelayedUpdate(this->stepmode, stepmode, PERSISTMOTOR);
 }
 
 void SetupData::set_coilpower(byte coilpower)
 {
-  this->StartDelayedUpdate(this->coilpower, coilpower);
+  this->StartDelayedUpdate(this->coilpower, coilpower, PERSISTMOTOR);
 }
 
 void SetupData::set_reversedirection(byte reversedirection)
 {
-  this->StartDelayedUpdate(this->reversedirection, reversedirection);
+  this->StartDelayedUpdate(this->reversedirection, reversedirection, PERSISTMOTOR);
 }
 
 void SetupData::set_stepsizeenabled(byte stepsizeenabled)
 {
-  this->StartDelayedUpdate(this->stepsizeenabled, stepsizeenabled); // if 1, controller returns step size
+  this->StartDelayedUpdate(this->stepsizeenabled, stepsizeenabled, PERSISTMOTOR); // if 1, controller returns step size
 }
 
 void SetupData::set_tempmode(byte tempmode)
 {
-  this->StartDelayedUpdate(this->tempmode, tempmode); // temperature display mode, Celcius=1, Fahrenheit=0
+  this->StartDelayedUpdate(this->tempmode, tempmode, PERSISTTEMP); // temperature display mode, Celcius=1, Fahrenheit=0
 }
 
 void SetupData::set_lcdupdateonmove(byte lcdupdateonmove)
 {
-  this->StartDelayedUpdate(this->lcdupdateonmove, lcdupdateonmove); // update position on lcd when moving
+  this->StartDelayedUpdate(this->lcdupdateonmove, lcdupdateonmove, PERSISTDISPLAY); // update position on lcd when moving
 }
 
 void SetupData::set_lcdpagetime(byte lcdpagetime)
 {
-  this->StartDelayedUpdate(this->lcdpagetime, lcdpagetime);
+  this->StartDelayedUpdate(this->lcdpagetime, lcdpagetime, PERSISTDISPLAY);
 }
 
 void SetupData::set_tempcompenabled(byte tempcompenabled)
 {
-  this->StartDelayedUpdate(this->tempcompenabled, tempcompenabled); // indicates if temperature compensation is enabled
+  this->StartDelayedUpdate(this->tempcompenabled, tempcompenabled, PERSISTTEMP); // indicates if temperature compensation is enabled
 }
 
 void SetupData::set_tcdirection(byte tcdirection)
 {
-  this->StartDelayedUpdate(this->tcdirection, tcdirection);
+  this->StartDelayedUpdate(this->tcdirection, tcdirection, PERSISTTEMP);
 }
 
 void SetupData::set_motorSpeed(byte motorSpeed)
 {
-  this->StartDelayedUpdate(this->motorSpeed, motorSpeed);
+  this->StartDelayedUpdate(this->motorSpeed, motorSpeed, PERSISTMOTOR);
 }
 
 void SetupData::set_displayenabled(byte displaystate)
 {
-  this->StartDelayedUpdate(this->displayenabled, displaystate);
+  this->StartDelayedUpdate(this->displayenabled, displaystate, PERSISTDISPLAY);
 }
 
 void SetupData::set_focuserpreset(byte idx, unsigned long pos)
 {
-  this->StartDelayedUpdate(this->preset[idx % 10], pos);
+  this->StartDelayedUpdate(this->preset[idx % 10], pos, PERSISTPRESETS);
 }
 
 void SetupData::set_webserverport(unsigned long wsp)
 {
-  this->StartDelayedUpdate(this->webserverport, wsp);
+  this->StartDelayedUpdate(this->webserverport, wsp, PERSISTNETWORK);
 }
 
 void SetupData::set_ascomalpacaport(unsigned long asp)
 {
-  this->StartDelayedUpdate(this->ascomalpacaport, asp);
+  this->StartDelayedUpdate(this->ascomalpacaport, asp, PERSISTNETWORK);
 }
 
 void SetupData::set_webpagerefreshrate(int rr)
 {
-  this->StartDelayedUpdate(this->webpagerefreshrate, rr);
+  this->StartDelayedUpdate(this->webpagerefreshrate, rr, PERSISTNETWORK);
 }
 
 void SetupData::set_mdnsport(unsigned long port)
 {
-  this->StartDelayedUpdate(this->mdnsport, port);
+  this->StartDelayedUpdate(this->mdnsport, port, PERSISTNETWORK);
 }
 
 void SetupData::set_tcpipport(unsigned long port)
 {
-  this->StartDelayedUpdate(this->tcpipport, port);
+  this->StartDelayedUpdate(this->tcpipport, port, PERSISTNETWORK);
 }
 
 void SetupData::set_showstartscreen(byte newval)
 {
-  this->StartDelayedUpdate(this->startscreen, newval);
+  this->StartDelayedUpdate(this->startscreen, newval, PERSISTDISPLAY);
 }
 
 void SetupData::set_wp_backcolor(String newstr)
 {
-  this->StartDelayedUpdate(this->backcolor, newstr);
+  this->StartDelayedUpdate(this->backcolor, newstr, PERSISTCOLORS);
 }
 
 void SetupData::set_wp_textcolor(String newstr)
 {
-  this->StartDelayedUpdate(this->textcolor, newstr);
+  this->StartDelayedUpdate(this->textcolor, newstr, PERSISTCOLORS);
 }
 
 void SetupData::set_wp_headercolor(String newstr)
 {
-  this->StartDelayedUpdate(this->headercolor, newstr);
+  this->StartDelayedUpdate(this->headercolor, newstr, PERSISTCOLORS);
 }
 
 void SetupData::set_wp_titlecolor(String newstr)
 {
-  this->StartDelayedUpdate(this->titlecolor, newstr);
+  this->StartDelayedUpdate(this->titlecolor, newstr, PERSISTCOLORS);
 }
 
 void SetupData::set_ascomserverstate(byte newval)
 {
-  this->StartDelayedUpdate(this->ascomserverstate, newval);
+  this->StartDelayedUpdate(this->ascomserverstate, newval, PERSISTNETWORK);
 }
 
 void SetupData::set_webserverstate(byte newval)
 {
-  this->StartDelayedUpdate(this->webserverstate, newval);
+  this->StartDelayedUpdate(this->webserverstate, newval, PERSISTNETWORK);
 }
 
 void SetupData::set_temperatureprobestate(byte newval)
 {
-  this->StartDelayedUpdate(this->temperatureprobestate, newval);
+  this->StartDelayedUpdate(this->temperatureprobestate, newval, PERSISTTEMP);
 }
 
 void SetupData::set_inoutledstate(byte newval)
 {
-  this->StartDelayedUpdate(this->inoutledstate, newval);
+  this->StartDelayedUpdate(this->inoutledstate, newval, PERSISTDISPLAY);
 }
 
 void SetupData::set_showhpswmsg(byte newval)
 {
-  this->StartDelayedUpdate(this->showhpswmessages, newval);
+  this->StartDelayedUpdate(this->showhpswmessages, newval, PERSISTDISPLAY);
 }
 
 void SetupData::set_forcedownload(byte newval)
 {
-  this->StartDelayedUpdate(this->forcedownload, newval);
+  this->StartDelayedUpdate(this->forcedownload, newval, PERSISTNETWORK);
 }
 
 void SetupData::set_oledpageoption(String newval)
 {
-  this->StartDelayedUpdate(this->oledpageoption, newval);
+  this->StartDelayedUpdate(this->oledpageoption, newval, PERSISTDISPLAY);
 }
 
 void SetupData::set_motorspeeddelay(int newval)
 {
-  this->StartDelayedUpdate(this->motorspeeddelay, newval);
+  this->StartDelayedUpdate(this->motorspeeddelay, newval, PERSISTMOTOR);
 }
 
 void SetupData::set_homepositionswitch(int newval)
 {
-  this->StartDelayedUpdate(this->homepositionswitch, newval);
+  this->StartDelayedUpdate(this->homepositionswitch, newval, PERSISTMOTOR);
+}
+
+void SetupData::set_motoraccel(int newval)
+{
+  this->StartDelayedUpdate(this->motoraccel, newval, PERSISTMOTOR);
+}
+
+void SetupData::set_maxspeeddelay(int newval)
+{
+  this->StartDelayedUpdate(this->maxspeeddelay, newval, PERSISTMOTOR);
 }
 
-void SetupData::StartDelayedUpdate(int & org_data, int new_data)
+void SetupData::StartDelayedUpdate(int & org_data, int new_data, byte group)
 {
   if (org_data != new_data)
   {
-    this->ReqSaveData_per = true;
-    this->SnapShotMillis = millis();
+    this->ReqSaveData_per |= group;
+    this->SnapShotMillis = halmillis();
     org_data = new_data;
     DebugPrintln(F("++ request for saving persitant data"));
   }
 }
 
-void SetupData::StartDelayedUpdate(unsigned long & org_data, unsigned long new_data)
+void SetupData::StartDelayedUpdate(unsigned long & org_data, unsigned long new_data, byte group)
 {
   if (org_data != new_data)
   {
-    this->ReqSaveData_per = true;
-    this->SnapShotMillis = millis();
+    this->ReqSaveData_per |= group;
+    this->SnapShotMillis = halmillis();
     org_data = new_data;
     DebugPrintln(F("++ request for saving persitant data"));
   }
 }
 
-void SetupData::StartDelayedUpdate(float & org_data, float new_data)
+void SetupData::StartDelayedUpdate(float & org_data, float new_data, byte group)
 {
   if (org_data != new_data)
   {
-    this->ReqSaveData_per = true;
-    this->SnapShotMillis = millis();
+    this->ReqSaveData_per |= group;
+    this->SnapShotMillis = halmillis();
     org_data = new_data;
     DebugPrintln(F("++ request for saving persitant data"));
   }
 }
 
-void SetupData::StartDelayedUpdate(byte & org_data, byte new_data)
+void SetupData::StartDelayedUpdate(byte & org_data, byte new_data, byte group)
 {
   if (org_data != new_data)
   {
-    this->ReqSaveData_per = true;
-    this->SnapShotMillis = millis();
+    this->ReqSaveData_per |= group;
+    this->SnapShotMillis = halmillis();
     org_data = new_data;
     DebugPrintln(F("++ request for saving persitant data"));
   }
 }
 
-void SetupData::StartDelayedUpdate(String & org_data, String new_data)
+void SetupData::StartDelayedUpdate(String & org_data, String new_data, byte group)
 {
   if (org_data != new_data)
   {
-    this->ReqSaveData_per = true;
-    this->SnapShotMillis = millis();
+    this->ReqSaveData_per |= group;
+    this->SnapShotMillis = halmillis();
     org_data = new_data;
     DebugPrintln("Save request for data_per.jsn");
   }
@@ -911,8 +1412,8 @@ void SetupData::ListDir(const char * dirname, uint8_t levels)
   Serial.println("SetupData::ListDir() does not work on ESP8266");
   // this does not work;
 #else
-  File root = SPIFFS.open(dirname);
-  delay(10);
+  halfile_t root = HALFS.open(dirname);
+  haldelay(10);
   if (!root)
   {
     DebugPrintln(F(" - failed to open directory"));
@@ -925,8 +1426,8 @@ void SetupData::ListDir(const char * dirname, uint8_t levels)
     }
     else
     {
-      File file = root.openNextFile();
-      delay(10);
+      halfile_t file = root.openNextFile();
+      haldelay(10);
       int i = 0;
       while (file)
       {
@@ -953,7 +1454,7 @@ void SetupData::ListDir(const char * dirname, uint8_t levels)
             DebugPrint(F("  "));
           }
         }
-        delay(10);
+        haldelay(10);
         file = root.openNextFile();
       }
       DebugPrintln("}");
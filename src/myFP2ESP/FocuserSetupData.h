@@ -12,6 +12,7 @@
 #include <Arduino.h>
 
 #include "generalDefinitions.h"
+#include "hal.h"
 
 //#define DEFAULTPOSITION       5000L               // moved to generalDefinitions.h
 //#define DEFAULTMAXSTEPS       80000L
@@ -21,6 +22,146 @@
 #define DEFAULTFAHREN           0
 #define DEFAULTDOCSIZE          2048
 #define DEFAULTVARDOCSIZE       64
+#define POSJOURNALRECORDS       512                 // records in the position journal before it is compacted
+
+// binary settings, one field group per record, each a header followed by the group struct. A setter
+// marks its group dirty and only dirty groups are written, so changing a web colour does not rewrite
+// the motor or backlash settings.
+// each group has two slots, /data_per<n>a.bin and /data_per<n>b.bin. A save overwrites the older slot
+// with the next generation, the newer slot is never touched, so a reset during a save leaves the
+// previous settings in place. At boot the valid slot with the highest generation wins
+// fields are only ever added at the end of a group struct, a record from an older version is shorter
+// and the fields it does not have take their default values. Bump PERSISTVERSION when adding fields
+#define PERSISTMAGIC            0x5046              // "FP"
+#define PERSISTVERSION          1
+
+// field groups, bit n is stored in /data_per<n>a.bin and /data_per<n>b.bin
+#define PERSISTMOTOR            0x01
+#define PERSISTBACKLASH         0x02
+#define PERSISTTEMP             0x04
+#define PERSISTDISPLAY          0x08
+#define PERSISTPRESETS          0x10
+#define PERSISTNETWORK          0x20
+#define PERSISTCOLORS           0x40
+#define PERSISTALL              0x7F
+#define PERSISTGROUPS           7
+
+struct persistheader_t
+{
+  uint16_t magic;
+  uint16_t version;
+  uint32_t generation;              // incremented on each save of the group
+  uint16_t size;                    // bytes of the group struct that follow
+  uint16_t crc;                     // crc16 of generation and those bytes
+};
+
+struct persistmotor_t
+{
+  uint32_t maxstep;
+  float    stepsize;
+  int32_t  stepmode;
+  int32_t  motorspeeddelay;
+  int32_t  homepositionswitch;
+  int32_t  motoraccel;
+  int32_t  maxspeeddelay;
+  uint8_t  DelayAfterMove;
+  uint8_t  coilpower;
+  uint8_t  reversedirection;
+  uint8_t  stepsizeenabled;
+  uint8_t  motorSpeed;
+  uint8_t  reserved[3];
+};
+
+struct persistbacklash_t
+{
+  uint8_t  backlashsteps_in;
+  uint8_t  backlashsteps_out;
+  uint8_t  backlash_in_enabled;
+  uint8_t  backlash_out_enabled;
+};
+
+struct persisttemp_t
+{
+  uint8_t  tempcoefficient;
+  uint8_t  tempresolution;
+  uint8_t  tempmode;
+  uint8_t  tempcompenabled;
+  uint8_t  tcdirection;
+  uint8_t  temperatureprobestate;
+};
+
+struct persistdisplay_t
+{
+  uint8_t  lcdupdateonmove;
+  uint8_t  lcdpagetime;
+  uint8_t  displayenabled;
+  uint8_t  startscreen;
+  uint8_t  showhpswmessages;
+  uint8_t  inoutledstate;
+  char     oledpageoption[16];
+};
+
+struct persistpresets_t
+{
+  uint32_t preset[10];
+};
+
+struct persistnetwork_t
+{
+  uint32_t webserverport;
+  uint32_t ascomalpacaport;
+  uint32_t mdnsport;
+  uint32_t tcpipport;
+  int32_t  webpagerefreshrate;
+  uint8_t  ascomserverstate;
+  uint8_t  webserverstate;
+  uint8_t  forcedownload;
+  uint8_t  reserved;
+};
+
+struct persistcolors_t
+{
+  char     backcolor[8];
+  char     textcolor[8];
+  char     headercolor[8];
+  char     titlecolor[8];
+};
+
+// all groups, in PERSIST bit order
+struct persistdata_t
+{
+  persistmotor_t    motor;
+  persistbacklash_t backlash;
+  persisttemp_t     temp;
+  persistdisplay_t  display;
+  persistpresets_t  presets;
+  persistnetwork_t  network;
+  persistcolors_t   colors;
+};
+
+// position journal record, appended to /data_pos.jnl each time the focuser stops at a new position
+// the record with the highest valid seq is the current position, a torn last record fails the crc
+struct posrecord_t
+{
+  uint32_t seq;
+  uint32_t position;
+  uint8_t  direction;
+  uint8_t  reserved;
+  uint16_t crc;                     // crc16 of the fields above
+};
+
+// the structs above are written to flash as they are. Fields are naturally aligned and the padding
+// is named, so the layout is the same with any compiler. A layout change fails the build here, only
+// add fields at the end of a group, bump PERSISTVERSION and then the size below
+static_assert(sizeof(persistheader_t) == 12, "persistheader_t layout changed");
+static_assert(sizeof(persistmotor_t) == 36, "persistmotor_t layout changed");
+static_assert(sizeof(persistbacklash_t) == 4, "persistbacklash_t layout changed");
+static_assert(sizeof(persisttemp_t) == 6, "persisttemp_t layout changed");
+static_assert(sizeof(persistdisplay_t) == 22, "persistdisplay_t layout changed");
+static_assert(sizeof(persistpresets_t) == 40, "persistpresets_t layout changed");
+static_assert(sizeof(persistnetwork_t) == 24, "persistnetwork_t layout changed");
+static_assert(sizeof(persistcolors_t) == 32, "persistcolors_t layout changed");
+static_assert(sizeof(posrecord_t) == 12, "posrecord_t layout changed");
 
 class SetupData
 {
@@ -29,6 +170,9 @@ class SetupData
     byte LoadConfiguration(void);
     boolean SaveConfiguration(unsigned long, byte);
     boolean SaveNow(void);
+    void PauseSaves(void);
+    void ResumeSaves(void);
+    String ExportConfiguration(void);
     void SetFocuserDefaults(void);
 
     //  getter
@@ -74,6 +218,8 @@ class SetupData
     String  get_oledpageoption();
     int get_motorspeeddelay();
     int get_homepositionswitch();
+    int get_motoraccel();
+    int get_maxspeeddelay();
       
     //__setter
     void set_fposition(unsigned long);
@@ -118,26 +264,48 @@ class SetupData
     void set_oledpageoption(String);
     void set_motorspeeddelay(int);
     void set_homepositionswitch(int);
+    void set_motoraccel(int);
+    void set_maxspeeddelay(int);
      
   private:
-    byte SavePersitantConfiguration();
+    byte SavePersitantConfiguration(byte);
     byte SaveVariableConfiguration();
+    void StartPersistantSave(byte);
+    boolean WritePersistantGroup(int, const persistdata_t &);
+#if defined(ESP32)
+    static void savetask(void *);
+#else
+    void WritePendingGroup(void);
+#endif
 
     void LoadDefaultPersistantData(void);
     void LoadDefaultVariableData(void);
 
-    void StartDelayedUpdate(unsigned long &, unsigned long);
-    void StartDelayedUpdate(float &, float);
-    void StartDelayedUpdate(byte &, byte);
-    void StartDelayedUpdate(int &, int);
-    void StartDelayedUpdate(String &, String);
+    boolean ImportConfiguration(void);
+    boolean LoadPersistantImage(void);
+    void PersistantFilename(char *, int, int);
+    void PackPersistant(persistdata_t &);
+    void UnpackPersistant(persistdata_t &);
+
+    boolean LoadJournal(void);
+    boolean WriteJournalRecord(halfile_t &);
+    boolean CompactJournal(void);
+    void RemoveJournal(void);
+
+    void StartDelayedUpdate(unsigned long &, unsigned long, byte);
+    void StartDelayedUpdate(float &, float, byte);
+    void StartDelayedUpdate(byte &, byte, byte);
+    void StartDelayedUpdate(int &, int, byte);
+    void StartDelayedUpdate(String &, String, byte);
     void ListDir(const char*, uint8_t);
 
     boolean ReqSaveData_var;        // Flag for request save variable data
-    boolean ReqSaveData_per;        // Flag for request save persitant data
+    byte ReqSaveData_per;           // PERSIST groups changed since the last save
 
-    const String filename_persistant = "/data_per.jsn"; // persistant JSON setup data
-    const String filename_variable = "/data_var.jsn";    // variable  JSON setup data
+    const String filename_persistant = "/data_per.jsn"; // persistant JSON setup data, imported if present
+    const String filename_variable = "/data_var.jsn";    // variable  JSON setup data, read if there is no journal
+    const String filename_journal = "/data_pos.jnl";     // position journal
+    const String filename_journalnew = "/data_pos.new";  // compacted journal, renamed to filename_journal
 
     unsigned long fposition;        // last focuser position
     byte focuserdirection;          // keeps track of last focuser move direction
@@ -145,6 +313,23 @@ class SetupData
     // unsigned long fposition_org;    // last focuser position
     // byte focuserdirection_org;      // keeps track of last focuser move direction
     unsigned long SnapShotMillis;
+    unsigned long savedposition;    // position and direction in the last journal record
+    byte saveddirection;
+    uint32_t journalseq;            // seq of the last journal record
+    int journalcount;               // records in filename_journal
+    uint32_t persistgen[PERSISTGROUPS];  // generation of the newest record of each group
+    byte persistslot[PERSISTGROUPS];     // slot holding it, the next save goes to the other slot
+
+    // settings saves are written in the background from a snapshot, on the ESP32 by savetask, on the
+    // ESP8266 one group per SaveConfiguration() call from loop()
+    persistdata_t pendingimg;       // snapshot of the settings waiting to be written
+    byte pendinggroups;             // groups of pendingimg not written yet
+#if defined(ESP32)
+    TaskHandle_t savetaskhandle;
+    SemaphoreHandle_t persistlock;  // held while groups are written, persistgen and persistslot belong to the holder
+    portMUX_TYPE pendinglock;       // guards pendingimg and pendinggroups
+    byte savespaused;               // set by PauseSaves() while the motor moves, written under persistlock
+#endif
 
     // dataset_persistant
     unsigned long maxstep;          // max steps
@@ -187,4 +372,6 @@ class SetupData
     String oledpageoption;
     int motorspeeddelay;
     int homepositionswitch;
+    int motoraccel;                 // acceleration in steps/s/s, 0 = disabled, move at motorspeeddelay
+    int maxspeeddelay;              // step interval in uS at top speed when acceleration is enabled
 };
@@ -1879,10 +1879,15 @@ void MANAGEMENT_sendjson(String str)
 void MANAGEMENT_handleget(void)
 {
   // return json string of state, on or off or value
-  // ascom, leds, temp, webserver, position, ismoving, display, motorspeed, coilpower, reverse
+  // ascom, leds, temp, webserver, position, ismoving, display, motorspeed, coilpower, reverse, accel, maxspeeddelay, steptiming, config
   String jsonstr;
 
-  if ( mserver.argName(0) == "ascom" )
+  if ( mserver.argName(0) == "config" )
+  {
+    // all persistant settings, save as data_per.jsn and upload it to import them at the next boot
+    MANAGEMENT_sendjson(mySetupData->ExportConfiguration());
+  }
+  else if ( mserver.argName(0) == "ascom" )
   {
     jsonstr = "{\"ascomserver\":" + String(mySetupData->get_ascomserverstate()) + " }";
     MANAGEMENT_sendjson(jsonstr);
@@ -1943,6 +1948,52 @@ void MANAGEMENT_handleget(void)
     jsonstr = "{ \"hpsw\":" + String(mySetupData->get_homepositionswitch()) + " }";
     MANAGEMENT_sendjson(jsonstr);
   }
+  else if ( mserver.argName(0) == "accel" )
+  {
+    jsonstr = "{ \"accel\":" + String(mySetupData->get_motoraccel()) + " }";
+    MANAGEMENT_sendjson(jsonstr);
+  }
+  else if ( mserver.argName(0) == "maxspeeddelay" )
+  {
+    jsonstr = "{ \"maxspeeddelay\":" + String(mySetupData->get_maxspeeddelay()) + " }";
+    MANAGEMENT_sendjson(jsonstr);
+  }
+#ifdef STEPTIMING
+  else if ( mserver.argName(0) == "steptiming" )
+  {
+    // all values in CPU cycles, late/isr are log2 histograms, bin n counts 2^(n-1) to 2^n - 1 cycles
+    steptiming_t st;
+    driverboard->getsteptiming(&st);
+    jsonstr = "{ \"steptiming\":{ \"samples\":" + String(st.samples) + ", \"mhz\":" + String(st.mhz);
+    jsonstr += ", \"latemax\":" + String(st.latemax) + ", \"isrmax\":" + String(st.isrmax);
+    jsonstr += ", \"late\":[";
+    for ( int i = 0; i < STEPTIMINGBINS; i++ )
+    {
+      jsonstr += ( i == 0 ) ? "" : ",";
+      jsonstr += String(st.late[i]);
+    }
+    jsonstr += "], \"isr\":[";
+    for ( int i = 0; i < STEPTIMINGBINS; i++ )
+    {
+      jsonstr += ( i == 0 ) ? "" : ",";
+      jsonstr += String(st.isr[i]);
+    }
+    jsonstr += "], \"recentlate\":[";
+    for ( uint32_t i = 0; i < st.recent; i++ )
+    {
+      jsonstr += ( i == 0 ) ? "" : ",";
+      jsonstr += String(st.recentlate[i]);
+    }
+    jsonstr += "], \"recentisr\":[";
+    for ( uint32_t i = 0; i < st.recent; i++ )
+    {
+      jsonstr += ( i == 0 ) ? "" : ",";
+      jsonstr += String(st.recentisr[i]);
+    }
+    jsonstr += "] } }";
+    MANAGEMENT_sendjson(jsonstr);
+  }
+#endif
   else
   {
     jsonstr = "{ \"error\":\"unknown-command\" }";
@@ -1956,7 +2007,7 @@ void MANAGEMENT_handleset(void)
   // get parameter after ?
   String value;
   bool rflag = false;
-  // ascom, leds, tempprobe, webserver, position, move, display, motorspeed, coilpower, reverse
+  // ascom, leds, tempprobe, webserver, position, move, display, motorspeed, coilpower, reverse, accel, maxspeeddelay, steptiming
 
   // ascom remote server
   value = mserver.arg("ascom");
@@ -2187,6 +2238,42 @@ void MANAGEMENT_handleset(void)
     }
   }
 
+  // acceleration in steps/s/s, 0 disables the ramp
+  value = mserver.arg("accel");
+  if ( value != "" )
+  {
+    int tmp = value.toInt();
+    DebugPrint("accel:");
+    DebugPrintln(tmp);
+    tmp = (tmp < 0) ? 0 : tmp;
+    driverboard->setaccel(tmp);
+    mySetupData->set_motoraccel(tmp);
+    rflag = true;
+  }
+
+  // step interval in uS at top speed when ramping
+  value = mserver.arg("maxspeeddelay");
+  if ( value != "" )
+  {
+    int tmp = value.toInt();
+    DebugPrint("maxspeeddelay:");
+    DebugPrintln(tmp);
+    driverboard->setmaxspeeddelay(tmp);
+    mySetupData->set_maxspeeddelay(driverboard->getmaxspeeddelay());
+    rflag = true;
+  }
+
+#ifdef STEPTIMING
+  // clear the step timing histograms
+  value = mserver.arg("steptiming");
+  if ( value == "reset" )
+  {
+    DebugPrintln("steptiming: reset");
+    driverboard->resetsteptiming();
+    rflag = true;
+  }
+#endif
+
   // send generic OK
   if ( rflag == true )
   {
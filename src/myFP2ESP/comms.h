@@ -12,6 +12,8 @@
 #ifndef comms_h
 #define comms_h
 
+#include "crc16.h"
+
 // ---------------------------------------------------------------------------
 // EXTERNS
 // ---------------------------------------------------------------------------
@@ -40,29 +42,133 @@ extern void init_homepositionswitch(void);
 // ---------------------------------------------------------------------------
 // DATA
 // ---------------------------------------------------------------------------
+// the frame being processed, :xxyyyy without the terminating #, parsed in place so no String is made
+char cmdbuffer[CMDBUFFERSIZE];
+byte cmdopcode = 0;                            // opcode being run, binary replies carry it
+
+// :86# subscription, the client is sent NOTIFYTOKEN frames without asking for them
+struct notify_t
+{
+  long interval;                               // position frame every interval steps while moving, 0 is not subscribed
+  unsigned long last;                          // position in the last frame sent
+};
+
+#if defined(ACCESSPOINT) || defined(STATIONMODE)
+// up to MAXTCPCLIENTS are served round robin, each has its own framing state so one client sending
+// part of a frame, or a lot of frames, does not hold up the others
+struct tcpclient_t
+{
+  haltcpclient_t client;
+  char frame[CMDBUFFERSIZE];                   // a frame can arrive over several loop() passes, built up here until the # arrives
+  int  framelen;
+  bool overflow;                               // frame too long, drop it up to the next #
+  notify_t notify;
+  bool binary;                                 // :591# switched this client to binary frames
+};
+
+tcpclient_t tcpclients[MAXTCPCLIENTS];
+byte currentclient = 0;                        // client being served, replies go to it
+byte firstclient = 0;                          // client served first in the next pass
+
+// replies to the frames of one pass are collected here and written to the client in one go
+char replybuffer[REPLYBUFFERSIZE];
+int  replylen = 0;
+#else
+notify_t notify;                               // serial and bluetooth have one client
+#endif
 
 // ---------------------------------------------------------------------------
 // CODE
 // ---------------------------------------------------------------------------
 #if defined(ACCESSPOINT) || defined(STATIONMODE) || defined(LOCALSERIAL) || defined(BLUETOOTHMODE)
 
+#if defined(ACCESSPOINT) || defined(STATIONMODE)
+void FlushReplies(void)
+{
+  if ( replylen )
+  {
+    tcpclients[currentclient].client.write((const uint8_t *) replybuffer, replylen);
+    replylen = 0;
+  }
+}
+#endif
+
+// write len bytes to the client, tcp replies are collected in replybuffer until FlushReplies()
+void SendBytes(const uint8_t *data, int len)
+{
+#if defined(ACCESSPOINT) || defined(STATIONMODE)  // for Accesspoint or Station mode
+  if ( (replylen + len) > REPLYBUFFERSIZE )
+  {
+    FlushReplies();
+  }
+  if ( len > REPLYBUFFERSIZE )
+  {
+    tcpclients[currentclient].client.write(data, len);
+  }
+  else
+  {
+    memcpy(replybuffer + replylen, data, len);
+    replylen += len;
+  }
+#elif defined(BLUETOOTHMODE)  // for bluetooth
+  SerialBT.write(data, len);
+#elif defined(LOCALSERIAL)
+  Serial.write(data, len);
+#endif
+}
+
+// true if replies to the current client go out as binary frames
+inline bool binarymode(void)
+{
+#if defined(ACCESSPOINT) || defined(STATIONMODE)
+  return tcpclients[currentclient].binary;
+#else
+  return false;
+#endif
+}
+
+// binary reply, BINSYNC opcode type lenlo lenhi payload crclo crchi, crc is over opcode to the end of the payload
+// values in the payload are little endian, the native order of the ESP8266 and ESP32
+void SendFrame(byte type, const void *payload, int len)
+{
+  uint8_t header[BINHEADERSIZE] = { BINSYNC, cmdopcode, type, (uint8_t) (len & 0xFF), (uint8_t) (len >> 8) };
+  uint16_t crc = crc16(0xFFFF, header + 1, BINHEADERSIZE - 1);
+  crc = crc16(crc, (const uint8_t *) payload, len);
+  uint8_t trailer[2] = { (uint8_t) (crc & 0xFF), (uint8_t) (crc >> 8) };
+  SendBytes(header, BINHEADERSIZE);
+  if ( len )
+  {
+    SendBytes((const uint8_t *) payload, len);
+  }
+  SendBytes(trailer, 2);
+#if defined(ACCESSPOINT) || defined(STATIONMODE)
+  packetssent++;
+#endif
+}
+
 void SendMessage(const char *str)
 {
   DebugPrint(SENDSTR);
   DebugPrintln(str);
 
-#if defined(ACCESSPOINT) || defined(STATIONMODE)  // for Accesspoint or Station mode
-  myclient.print(str);
+  if ( binarymode() )
+  {
+    SendFrame(BIN_TEXT, str, strlen(str));
+    return;
+  }
+  SendBytes((const uint8_t *) str, strlen(str));
+#if defined(ACCESSPOINT) || defined(STATIONMODE)
   packetssent++;
-#elif defined(BLUETOOTHMODE)  // for bluetooth
-  SerialBT.print(str);
-#elif defined(LOCALSERIAL)
-  Serial.print(str);
 #endif
 }
 
 void SendPaket(const char token, const char *str)
 {
+  if ( binarymode() )
+  {
+    SendFrame(BIN_TEXT, str, strlen(str));
+    return;
+  }
   char buffer[32];
   snprintf(buffer, sizeof(buffer), "%c%s%c", token,  str, EOFSTR);
   SendMessage(buffer);
@@ -70,6 +176,11 @@ void SendPaket(const char token, const char *str)
 
 void SendPaket(const char token, const unsigned char val)
 {
+  if ( binarymode() )
+  {
+    SendFrame(BIN_U8, &val, 1);
+    return;
+  }
   char buffer[32];
 
   snprintf(buffer, sizeof(buffer), "%c%u%c", token,  val, EOFSTR);
@@ -78,6 +189,12 @@ void SendPaket(const char token, const unsigned char val)
 
 void SendPaket(const char token, const int val)
 {
+  if ( binarymode() )
+  {
+    int32_t bval = val;
+    SendFrame(BIN_I32, &bval, 4);
+    return;
+  }
   char buffer[32];
   snprintf(buffer, sizeof(buffer), "%c%i%c", token,  val, EOFSTR);
   SendMessage(buffer);
@@ -85,6 +202,12 @@ void SendPaket(const char token, const int val)
 
 void SendPaket(const char token, const unsigned long val)
 {
+  if ( binarymode() )
+  {
+    uint32_t bval = val;
+    SendFrame(BIN_U32, &bval, 4);
+    return;
+  }
   char buffer[32];
   snprintf(buffer, sizeof(buffer), "%c%lu%c", token,  val, EOFSTR);
   SendMessage(buffer);
@@ -92,6 +215,12 @@ void SendPaket(const char token, const unsigned long val)
 
 void SendPaket(const char token, const long val)
 {
+  if ( binarymode() )
+  {
+    int32_t bval = val;
+    SendFrame(BIN_I32, &bval, 4);
+    return;
+  }
   char buffer[32];
   snprintf(buffer, sizeof(buffer), "%c%ld%c", token,  val, EOFSTR);
   SendMessage(buffer);
@@ -99,6 +228,11 @@ void SendPaket(const char token, const long val)
 
 void SendPaket(const char token, const float val, int i)    // i => decimal place
 {
+  if ( binarymode() )
+  {
+    SendFrame(BIN_F32, &val, 4);
+    return;
+  }
   char buff[32];
   char temp[8];
   // Note Arduino snprintf does not support .2f
@@ -107,623 +241,1380 @@ void SendPaket(const char token, const float val, int i)    // i => decimal plac
   SendMessage(buff);
 }
 
-void ESP_Communication()
+// two digit command number at cmdbuffer[1], stops at the first non digit like String::toInt()
+byte cmdnumber(void)
 {
-  byte cmdval;
-  String receiveString = "";
-  String WorkString = "";
-  long paramval = 0;
+  byte val = 0;
+  for ( int i = 1; (i < 3) && isdigit(cmdbuffer[i]); i++ )
+  {
+    val = (val * 10) + (cmdbuffer[i] - '0');
+  }
+  return val;
+}
 
-#if defined(BLUETOOTHMODE)
-  receiveString = STARTCMDSTR + queue.pop();
-#elif defined(LOCALSERIAL)
-  receiveString = STARTCMDSTR + queue.pop();
-#else   // for Accesspoint or Station mode
-  packetsreceived++;
-  receiveString = myclient.readStringUntil(EOFSTR);    // read until terminator
-#endif
+// numeric argument of the frame starting at cmdbuffer[offset]
+long cmdargint(byte offset)
+{
+  return atol(cmdbuffer + offset);
+}
 
-  receiveString += EOFSTR;                                // put back terminator
-  String cmdstr = receiveString.substring(1, 3);
-  cmdval = cmdstr.toInt();                                // convert command to an integer
-  DebugPrint("recstr=" + receiveString + "  ");
-  DebugPrintln("cmdstr=" + cmdstr);
-  switch (cmdval)
-  {
-    // all the get values first followed by set values
-    case 0: // get focuser position
-      SendPaket('P', driverboard->getposition());
-      break;
-    case 1: // ismoving
-      SendPaket('I', isMoving);
-      break;
-    case 2: // get controller status
-      SendPaket('E', "OK");
-      break;
-    case 3: // get firmware version
+float cmdargfloat(byte offset)
+{
+  return atof(cmdbuffer + offset);
+}
+
+// ---------------------------------------------------------------------------
+// COMMAND HANDLERS
+// ---------------------------------------------------------------------------
+// one handler per opcode, token is the reply token from cmdtable, arguments are read from cmdbuffer
+
+// commands that are accepted and ignored
+void cmd_none(char)
+{
+}
+
+// :00# get focuser position
+void cmd_getposition(char token)
+{
+  SendPaket(token, driverboard->getposition());
+}
+
+// :01# ismoving
+void cmd_getismoving(char token)
+{
+  SendPaket(token, isMoving);
+}
+
+// :02# get controller status
+void cmd_getstatus(char token)
+{
+  SendPaket(token, "OK");
+}
+
+// :03# get firmware version
+void cmd_getversion(char token)
+{
 #ifdef INDI
-      SendPaket('F', "291");
+  SendPaket(token, "291");
 #else
-      SendPaket('F', programVersion);
+  SendPaket(token, programVersion);
 #endif
-      break;
-    case 4: // get firmware name
-      char buffer[32];
-      snprintf(buffer, sizeof(buffer), "%s\r\n%s",  DRVBRD_ID, programVersion );
-      SendPaket('F', buffer);
-      break;
-    case 5: // :05xxxxxx# None    Set new target position to xxxxxx (and focuser initiates immediate move to xxxxxx)
-      // only if not already moving
-      if ( isMoving == 0 )
-      {
-        WorkString = receiveString.substring(3, receiveString.length() - 1);
-        ftargetPosition = (unsigned long)WorkString.toInt();
-        ftargetPosition = (ftargetPosition > mySetupData->get_maxstep()) ? mySetupData->get_maxstep() : ftargetPosition;
-        // main loop will update focuser positions
-      }
-      break;
-    case 6: // get temperature
-      SendPaket('Z', lasttemp, 3);
-      break;
-    case 7: // set maxsteps
-      {
-        WorkString = receiveString.substring(3, receiveString.length() - 1);
-        unsigned long tmppos = (unsigned long)WorkString.toInt();
-        delay(5);
-        // check to make sure not above largest value for maxstep
-        tmppos = (tmppos > FOCUSERUPPERLIMIT) ? FOCUSERUPPERLIMIT : tmppos;
-        // check if below lowest set value for maxstep
-        tmppos = (tmppos < FOCUSERLOWERLIMIT) ? FOCUSERLOWERLIMIT : tmppos;
-        // check to make sure its not less than current focuser position
-        tmppos = (tmppos < driverboard->getposition()) ? driverboard->getposition() : tmppos;
-        mySetupData->set_maxstep(tmppos);
-      }
-      break;
-    case 8: // get maxStep
-      SendPaket('M', mySetupData->get_maxstep());
-      break;
-    case 9:   // unused
-      break;
-    case 10: // get maxIncrement
-      SendPaket('Y', mySetupData->get_maxstep());
-      break;
-    case 11: // get coil power
-      SendPaket('O', mySetupData->get_coilpower());
-      break;
-    case 12: // set coil power
-      paramval = (byte) (receiveString[3] - '0');
-      ( paramval == 1 ) ? driverboard->enablemotor() : driverboard->releasemotor();
-      mySetupData->set_coilpower(paramval);
-      break;
-    case 13: // get reverse direction setting, 00 off, 01 on
-      SendPaket('R', mySetupData->get_reversedirection());
-      break;
-    case 14: // set reverse direction
-      if ( isMoving == 0 )
-      {
-        paramval = (byte) (receiveString[3] - '0');
-        ( paramval == 1 ) ? mySetupData->set_reversedirection(1) : mySetupData->set_reversedirection(0);
-      }
-      break;
-    case 15: // set motor speed
-      WorkString = receiveString.substring(3, receiveString.length() - 1);
-      paramval = (byte)WorkString.toInt() & 3;
-      mySetupData->set_motorSpeed((byte) paramval);
-      break;
-    case 16: // set display to celsius
-      mySetupData->set_tempmode(1); // temperature display mode, Celsius=1, Fahrenheit=0
-      break;
-    case 17: // set display to fahrenheit
-      mySetupData->set_tempmode(0); // temperature display mode, Celsius=1, Fahrenheit=0
-      break;
-    case 18:
-      // :180#    None    set the return of user specified stepsize to be OFF - default
-      // :181#    None    set the return of user specified stepsize to be ON - reports what user specified as stepsize
-      mySetupData->set_stepsizeenabled((byte) (receiveString[3] - '0'));
-      break;
-    case 19: // :19xxxx#  None   set the step size value - double type, eg 2.1
-      {
-        WorkString = receiveString.substring(3, receiveString.length() - 1);
-        float tempstepsize = (float)WorkString.toFloat();
-        tempstepsize = (tempstepsize < MINIMUMSTEPSIZE ) ? MINIMUMSTEPSIZE : tempstepsize;
-        tempstepsize = (tempstepsize > MAXIMUMSTEPSIZE ) ? MAXIMUMSTEPSIZE : tempstepsize;
-        mySetupData->set_stepsize(tempstepsize);
-      }
-      break;
-    case 20: // set the temperature resolution setting for the DS18B20 temperature probe
-      WorkString = receiveString.substring(3, receiveString.length() - 1);
-      paramval = WorkString.toInt();
-      mySetupData->set_tempresolution((byte) paramval);
-      if ( mySetupData->get_temperatureprobestate() == 1 )    // if temp probe is enabled
-      {
-        if ( tprobe1 != 0 )                                   // if probe was found
-        {
-          myTempProbe->temp_setresolution((byte) paramval);   // set probe resolution
-          mySetupData->set_tempresolution((byte) paramval);   // and save for future use
-        }
-      }
-      break;
-    case 21: // get temp probe resolution
-      SendPaket('Q', mySetupData->get_tempresolution());
-      break;
-    case 22: // set the temperature compensation value to xxx
-      WorkString = receiveString.substring(3, receiveString.length() - 1);
-      paramval = WorkString.toInt();
-      mySetupData->set_tempcoefficient((byte)paramval);
-      break;
-    case 23: // set the temperature compensation ON (1) or OFF (0)
-      if ( mySetupData->get_temperatureprobestate() == 1)
-      {
-        mySetupData->set_tempcompenabled((byte) (receiveString[3] - '0'));
-      }
-      break;
-    case 24: // get status of temperature compensation (enabled | disabled)
-      SendPaket('1', mySetupData->get_tempcompenabled());
-      break;
-    case 25: // get IF temperature compensation is available
-      if ( mySetupData->get_temperatureprobestate() == 1 )
-      {
-        SendPaket('A', "1"); // this focuser supports temperature compensation
-      }
-      else
-      {
-        SendPaket('A', "0");
-      }
-      break;
-    case 26: // get temperature coefficient steps/degree
-      SendPaket('B', mySetupData->get_tempcoefficient());
-      break;
-    case 27: // stop a move - like a Halt
-      halt_alert = true;
-      break;
-    case 28: // home the motor to position 0
-      ftargetPosition = 0; // if this is a home then set target to 0
-      break;
-    case 29: // get stepmode
-      SendPaket('S', mySetupData->get_stepmode());
-      break;
+}
+
+// :04# get firmware name
+void cmd_getname(char token)
+{
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%s\r\n%s",  DRVBRD_ID, programVersion );
+  SendPaket(token, buffer);
+}
+
+// :05xxxxxx# None    Set new target position to xxxxxx (and focuser initiates immediate move to xxxxxx)
+void cmd_movetoposition(char)
+{
+  // only if not already moving
+  if ( isMoving == 0 )
+  {
+    ftargetPosition = (unsigned long)cmdargint(3);
+    ftargetPosition = (ftargetPosition > mySetupData->get_maxstep()) ? mySetupData->get_maxstep() : ftargetPosition;
+    // main loop will update focuser positions
+#ifdef TIMEMOVESTART
+    firststeptime = 0;
+    movecmdtime = halmicros();
+#endif
+  }
+}
+
+// :06# get temperature
+void cmd_gettemperature(char token)
+{
+  SendPaket(token, lasttemp, 3);
+}
+
+// :07# set maxsteps
+void cmd_setmaxstep(char)
+{
+  unsigned long tmppos = (unsigned long)cmdargint(3);
+  haldelay(5);
+  // check to make sure not above largest value for maxstep
+  tmppos = (tmppos > FOCUSERUPPERLIMIT) ? FOCUSERUPPERLIMIT : tmppos;
+  // check if below lowest set value for maxstep
+  tmppos = (tmppos < FOCUSERLOWERLIMIT) ? FOCUSERLOWERLIMIT : tmppos;
+  // check to make sure its not less than current focuser position
+  tmppos = (tmppos < driverboard->getposition()) ? driverboard->getposition() : tmppos;
+  mySetupData->set_maxstep(tmppos);
+}
+
+// :08# get maxStep
+void cmd_getmaxstep(char token)
+{
+  SendPaket(token, mySetupData->get_maxstep());
+}
+
+// :10# get maxIncrement
+void cmd_getmaxincrement(char token)
+{
+  SendPaket(token, mySetupData->get_maxstep());
+}
+
+// :11# get coil power
+void cmd_getcoilpower(char token)
+{
+  SendPaket(token, mySetupData->get_coilpower());
+}
+
+// :12# set coil power
+void cmd_setcoilpower(char)
+{
+  long paramval = (byte) (cmdbuffer[3] - '0');
+  ( paramval == 1 ) ? driverboard->enablemotor() : driverboard->releasemotor();
+  mySetupData->set_coilpower(paramval);
+}
+
+// :13# get reverse direction setting, 00 off, 01 on
+void cmd_getreverse(char token)
+{
+  SendPaket(token, mySetupData->get_reversedirection());
+}
+
+// :14# set reverse direction
+void cmd_setreverse(char)
+{
+  long paramval;
+  if ( isMoving == 0 )
+  {
+    paramval = (byte) (cmdbuffer[3] - '0');
+    ( paramval == 1 ) ? mySetupData->set_reversedirection(1) : mySetupData->set_reversedirection(0);
+  }
+}
+
+// :15# set motor speed
+void cmd_setmotorspeed(char)
+{
+  long paramval = (byte)cmdargint(3) & 3;
+  mySetupData->set_motorSpeed((byte) paramval);
+}
+
+// :16# set display to celsius
+void cmd_setcelsius(char)
+{
+  mySetupData->set_tempmode(1); // temperature display mode, Celsius=1, Fahrenheit=0
+}
+
+// :17# set display to fahrenheit
+void cmd_setfahrenheit(char)
+{
+  mySetupData->set_tempmode(0); // temperature display mode, Celsius=1, Fahrenheit=0
+}
+
+// :18#
+void cmd_setstepsizeenabled(char)
+{
+  // :180#    None    set the return of user specified stepsize to be OFF - default
+  // :181#    None    set the return of user specified stepsize to be ON - reports what user specified as stepsize
+  mySetupData->set_stepsizeenabled((byte) (cmdbuffer[3] - '0'));
+}
 
-    case 30: // set step mode
-      WorkString = receiveString.substring(3, receiveString.length() - 1);
-      paramval = WorkString.toInt();
+// :19xxxx#  None   set the step size value - double type, eg 2.1
+void cmd_setstepsize(char)
+{
+  float tempstepsize = (float)cmdargfloat(3);
+  tempstepsize = (tempstepsize < MINIMUMSTEPSIZE ) ? MINIMUMSTEPSIZE : tempstepsize;
+  tempstepsize = (tempstepsize > MAXIMUMSTEPSIZE ) ? MAXIMUMSTEPSIZE : tempstepsize;
+  mySetupData->set_stepsize(tempstepsize);
+}
+
+// :20# set the temperature resolution setting for the DS18B20 temperature probe
+void cmd_settempresolution(char)
+{
+  long paramval = cmdargint(3);
+  mySetupData->set_tempresolution((byte) paramval);
+  if ( mySetupData->get_temperatureprobestate() == 1 )    // if temp probe is enabled
+  {
+    if ( tprobe1 != 0 )                                   // if probe was found
+    {
+      myTempProbe->temp_setresolution((byte) paramval);   // set probe resolution
+      mySetupData->set_tempresolution((byte) paramval);   // and save for future use
+    }
+  }
+}
+
+// :21# get temp probe resolution
+void cmd_gettempresolution(char token)
+{
+  SendPaket(token, mySetupData->get_tempresolution());
+}
+
+// :22# set the temperature compensation value to xxx
+void cmd_settempcoefficient(char)
+{
+  long paramval = cmdargint(3);
+  mySetupData->set_tempcoefficient((byte)paramval);
+}
+
+// :23# set the temperature compensation ON (1) or OFF (0)
+void cmd_settempcompenabled(char)
+{
+  if ( mySetupData->get_temperatureprobestate() == 1)
+  {
+    mySetupData->set_tempcompenabled((byte) (cmdbuffer[3] - '0'));
+  }
+}
+
+// :24# get status of temperature compensation (enabled | disabled)
+void cmd_gettempcompenabled(char token)
+{
+  SendPaket(token, mySetupData->get_tempcompenabled());
+}
+
+// :25# get IF temperature compensation is available
+void cmd_gettempcompavailable(char token)
+{
+  if ( mySetupData->get_temperatureprobestate() == 1 )
+  {
+    SendPaket(token, "1"); // this focuser supports temperature compensation
+  }
+  else
+  {
+    SendPaket(token, "0");
+  }
+}
+
+// :26# get temperature coefficient steps/degree
+void cmd_gettempcoefficient(char token)
+{
+  SendPaket(token, mySetupData->get_tempcoefficient());
+}
+
+// :27# stop a move - like a Halt
+void cmd_halt(char)
+{
+  halt_alert = true;
+}
+
+// :28# home the motor to position 0
+void cmd_home(char)
+{
+  ftargetPosition = 0; // if this is a home then set target to 0
+}
+
+// :29# get stepmode
+void cmd_getstepmode(char token)
+{
+  SendPaket(token, mySetupData->get_stepmode());
+}
+
+// :30# set step mode
+void cmd_setstepmode(char)
+{
+  long paramval = cmdargint(3);
 #if (DRVBRD == PRO2EULN2003 || DRVBRD == PRO2EL298N || DRVBRD == PRO2EL293DMINI || DRVBRD == PRO2EL9110S)
-      paramval = (byte)(paramval & 3);      // STEP1 - STEP2
+  paramval = (byte)(paramval & 3);      // STEP1 - STEP2
 #endif
 #if (DRVBRD == PRO2ESP32ULN2003 || DRVBRD == PRO2ESP32L298N || DRVBRD == PRO2ESP32L293DMINI || DRVBRD == PRO2ESP32L9110S)
-      paramval = (byte)(paramval & 3);      // STEP1 - STEP2
+  paramval = (byte)(paramval & 3);      // STEP1 - STEP2
 #endif
 #if (DRVBRD == WEMOSDRV8825 || DRVBRD == PRO2EDRV8825 || DRVBRD == PRO2EDRV8825BIG)
-      paramval = DRV8825TEPMODE;            // stepmopde set by jumpers
+  paramval = DRV8825TEPMODE;            // stepmopde set by jumpers
 #endif
 #if (DRVBRD == PRO2ESP32DRV8825 || DRVBRD == PRO2ESP32R3WEMOS)
-      if ( paramval < STEP1 )
-      {
-        paramval = STEP1;
-      }
-      else if ( paramval > STEP32 )
-      {
-        paramval = STEP32;
-      }
+  if ( paramval < STEP1 )
+  {
+    paramval = STEP1;
+  }
+  else if ( paramval > STEP32 )
+  {
+    paramval = STEP32;
+  }
 #endif
 #if (DRVBRD == PRO2EL293DNEMA || DRVBRD == PRO2EL293D28BYJ48)
-      paramval = STEP1;
+  paramval = STEP1;
 #endif
-      // this is the proper way to do this
-      driverboard->setstepmode(paramval);
-      mySetupData->set_stepmode(paramval);
-      break;
-    case 31: // set focuser position
-      if ( isMoving == 0 )
-      {
-        WorkString = receiveString.substring(3, receiveString.length() - 1);
-        {
-          long tpos = (long)WorkString.toInt();
-          tpos = (tpos < 0) ? 0 : tpos;
-          unsigned long tmppos = ((unsigned long) tpos > mySetupData->get_maxstep()) ? mySetupData->get_maxstep() : (unsigned long) tpos;
-          ftargetPosition = tmppos;
-          driverboard->setposition(tmppos);
-          mySetupData->set_fposition(tmppos);
-        }
-      }
-      break;
-    case 32: // get if stepsize is enabled
-      SendPaket('U', mySetupData->get_stepsizeenabled());
-      break;
-    case 33: // get stepsize
-      SendPaket('T', mySetupData->get_stepsize(), 3);       // ????????????? check format
-      break;
-    case 34: // get the time that an LCD screen is displayed for
-      SendPaket('X', mySetupData->get_lcdpagetime());
-      break;
-    case 35: // set length of time an LCD page is displayed for in seconds
-      WorkString = receiveString.substring(3, receiveString.length() - 1);
-      paramval = WorkString.toInt();
-      paramval = (paramval < LCDPAGETIMEMIN ) ? LCDPAGETIMEMIN : paramval;
-      paramval = (paramval > LCDPAGETIMEMAX ) ? LCDPAGETIMEMAX : paramval;
-      mySetupData->set_lcdpagetime((byte)paramval);
-      break;
-    case 36:
-      // :360#    None    Disable Display
-      // :361#    None    Enable Display
-#if defined(OLED_TEXT)
-      mySetupData->set_displayenabled((byte) (receiveString[3] - '0'));
-      if (mySetupData->get_displayenabled() == 1)
-      {
-        if ( displayfound == true )
-        {
-          myoled->Display_On();
-        }
-      }
-      else
-      {
-        if ( displayfound == true )
-        {
-          myoled->Display_Off();
-        }
-      }
+  // this is the proper way to do this
+  driverboard->setstepmode(paramval);
+  mySetupData->set_stepmode(paramval);
+}
+
+// :31# set focuser position
+void cmd_setposition(char)
+{
+  if ( isMoving == 0 )
+  {
+    {
+      long tpos = (long)cmdargint(3);
+      tpos = (tpos < 0) ? 0 : tpos;
+      unsigned long tmppos = ((unsigned long) tpos > mySetupData->get_maxstep()) ? mySetupData->get_maxstep() : (unsigned long) tpos;
+      ftargetPosition = tmppos;
+      driverboard->setposition(tmppos);
+      mySetupData->set_fposition(tmppos);
+    }
+  }
+}
+
+// :32# get if stepsize is enabled
+void cmd_getstepsizeenabled(char token)
+{
+  SendPaket(token, mySetupData->get_stepsizeenabled());
+}
+
+// :33# get stepsize
+void cmd_getstepsize(char token)
+{
+  SendPaket(token, mySetupData->get_stepsize(), 3);       // ????????????? check format
+}
+
+// :34# get the time that an LCD screen is displayed for
+void cmd_getlcdpagetime(char token)
+{
+  SendPaket(token, mySetupData->get_lcdpagetime());
+}
+
+// :35# set length of time an LCD page is displayed for in seconds
+void cmd_setlcdpagetime(char)
+{
+  long paramval = cmdargint(3);
+  paramval = (paramval < LCDPAGETIMEMIN ) ? LCDPAGETIMEMIN : paramval;
+  paramval = (paramval > LCDPAGETIMEMAX ) ? LCDPAGETIMEMAX : paramval;
+  mySetupData->set_lcdpagetime((byte)paramval);
+}
+
+// :36#
+void cmd_setdisplayenabled(char)
+{
+  // :360#    None    Disable Display
+  // :361#    None    Enable Display
+#if defined(OLED_TEXT)
+  mySetupData->set_displayenabled((byte) (cmdbuffer[3] - '0'));
+  if (mySetupData->get_displayenabled() == 1)
+  {
+    if ( displayfound == true )
+    {
+      myoled->Display_On();
+    }
+  }
+  else
+  {
+    if ( displayfound == true )
+    {
+      myoled->Display_Off();
+    }
+  }
 #endif // ifdef OLED_TEXT
-      break;
-    case 37: // get displaystatus
-      SendPaket('D', mySetupData->get_displayenabled());
-      break;
-    case 38: // :38#   Dxx#      Get Temperature mode 1=Celsius, 0=Fahrenheight
-      SendPaket('b', mySetupData->get_tempmode());
-      break;
-    case 39: // get the new motor position (target) XXXXXX
-      SendPaket('N', ftargetPosition);
-      break;
-    case 41:  // troubleshoot
-      break;
-    case 40: // reset Arduino myFocuserPro2E controller
-      software_Reboot(2000);      // reboot with 2s delay
-      break;
-    case 42: // reset focuser defaults
-      if ( isMoving == 0 )
-      {
-        mySetupData->SetFocuserDefaults();
-        ftargetPosition = mySetupData->get_fposition();
-        driverboard->setposition(ftargetPosition);
-        mySetupData->set_fposition(ftargetPosition);
-      }
-      break;
-    case 43: // get motorspeed
-      SendPaket('C', mySetupData->get_motorSpeed());
-      break;
-    case 44: // set motorspeed threshold when moving - switches to slowspeed when nearing destination
-      //ignore
-      break;
-    case 45: // get motorspeedchange threshold value
-      SendPaket('G', "200");
-      break;
-    case 46: // enable/Disable motorspeed change when moving
-      //ignore
-      break;
-    case 47: // get motorspeedchange enabled? on/off
-      SendPaket('J', "0");
-      break;
-    case 48: // save settings to FS
-      mySetupData->set_fposition(driverboard->getposition());       // need to save setting
-      mySetupData->SaveNow();                                       // save the focuser settings immediately
-      break;
-    case 49: // aXXXXX
-      SendPaket('a', "b552efd");
-      break;
-    case 50: // Get if Home Position Switch enabled, 0 = no, 1 = yes
-      if ( mySetupData->get_homepositionswitch() == 1)
-      {
-        SendPaket('l', 1);
-      }
-      else
-      {
-        SendPaket('l', 0);
-      }
-      break;
-    case 51: // return ESP8266Wifi Controller IP Address
-      SendPaket('d', ipStr);
-      break;
-    case 52: // return ESP32 Controller number of TCP packets sent
-      SendPaket('e', packetssent);
-      break;
-    case 53: // return ESP32 Controller number of TCP packets received
-      SendPaket('f', packetsreceived);
-      break;
-    case 54: // return ESP32 Controller SSID
+}
+
+// :37# get displaystatus
+void cmd_getdisplayenabled(char token)
+{
+  SendPaket(token, mySetupData->get_displayenabled());
+}
+
+// :38#   Dxx#      Get Temperature mode 1=Celsius, 0=Fahrenheight
+void cmd_gettempmode(char token)
+{
+  SendPaket(token, mySetupData->get_tempmode());
+}
+
+// :39# get the new motor position (target) XXXXXX
+void cmd_gettargetposition(char token)
+{
+  SendPaket(token, ftargetPosition);
+}
+
+// :40# reset Arduino myFocuserPro2E controller
+void cmd_reboot(char)
+{
+  software_Reboot(2000);      // reboot with 2s delay
+}
+
+// :42# reset focuser defaults
+void cmd_setdefaults(char)
+{
+  if ( isMoving == 0 )
+  {
+    mySetupData->SetFocuserDefaults();
+    ftargetPosition = mySetupData->get_fposition();
+    driverboard->setposition(ftargetPosition);
+    mySetupData->set_fposition(ftargetPosition);
+  }
+}
+
+// :43# get motorspeed
+void cmd_getmotorspeed(char token)
+{
+  SendPaket(token, mySetupData->get_motorSpeed());
+}
+
+// :45# get motorspeedchange threshold value
+void cmd_getspeedthreshold(char token)
+{
+  SendPaket(token, "200");
+}
+
+// :47# get motorspeedchange enabled? on/off
+void cmd_getspeedchange(char token)
+{
+  SendPaket(token, "0");
+}
+
+// :48# save settings to FS
+void cmd_savesettings(char)
+{
+  mySetupData->set_fposition(driverboard->getposition());       // need to save setting
+  mySetupData->SaveNow();                                       // save the focuser settings immediately
+}
+
+// :49# aXXXXX
+void cmd_getid(char token)
+{
+  SendPaket(token, "b552efd");
+}
+
+// :50# Get if Home Position Switch enabled, 0 = no, 1 = yes
+void cmd_gethpswenabled(char token)
+{
+  if ( mySetupData->get_homepositionswitch() == 1)
+  {
+    SendPaket(token, 1);
+  }
+  else
+  {
+    SendPaket(token, 0);
+  }
+}
+
+// :51# return ESP8266Wifi Controller IP Address
+void cmd_getipaddress(char token)
+{
+  SendPaket(token, ipStr);
+}
+
+// :52# return ESP32 Controller number of TCP packets sent
+void cmd_getpacketssent(char token)
+{
+  SendPaket(token, packetssent);
+}
+
+// :53# return ESP32 Controller number of TCP packets received
+void cmd_getpacketsreceived(char token)
+{
+  SendPaket(token, packetsreceived);
+}
+
+// :54# return ESP32 Controller SSID
+void cmd_getssid(char token)
+{
 #ifdef LOCALSERIAL
-      SendPaket('g', "SERIAL");
+  SendPaket(token, "SERIAL");
 #endif
 #ifdef BLUETOOTH
-      SendPaket('g', "BLUETOOTH");
+  SendPaket(token, "BLUETOOTH");
 #endif
 #if !defined(LOCALSERIAL) && !defined(BLUETOOTHMODE)
-      SendPaket('g', mySSID);
+  SendPaket(token, mySSID);
 #endif
-      break;
-    case 55: // get motorspeed delay for current speed setting
-      SendPaket('0', driverboard->getstepdelay());
-      break;
-    case 56: // set motorspeed delay for current speed setting
-      {
-        int newdelay = 1000;
-        WorkString = receiveString.substring(3, receiveString.length() - 1);
-        newdelay = WorkString.toInt();
-        newdelay = (newdelay < 1000) ? 1000 : newdelay;   // ensure it is not too low
-        driverboard->setstepdelay(newdelay);
-        mySetupData->set_motorspeeddelay(newdelay);
-      }
-      break;
-    case 57: // set Super Slow Jogging Speed
-      // ignore
-      break;
-    case 58: // get controller features .. deprecated
-      SendPaket('m', 0);
-      break;
-    case 59:  // Unused
-      // ignore
-      break;
-    case 60:  // set MotorSpeed when jogging
-      // ignore
-      break;
-    case 61: // set update of position on lcd when moving (0=disable, 1=enable)
-      mySetupData->set_lcdupdateonmove((byte) (receiveString[3] - '0'));
-      break;
-    case 62: // get update of position on lcd when moving (00=disable, 01=enable)
-      SendPaket('L', mySetupData->get_lcdupdateonmove());
-      break;
-    case 63: // get status of home position switch (0=off, 1=closed, position 0)
-      if ( mySetupData->get_homepositionswitch() == 1)
-      {
-        SendPaket('H', digitalRead(HPSWPIN));
-      }
-      else
-      {
-        SendPaket('H', "0");
-      }
-      break;
-    case 64: // move a specified number of steps
-      if ( isMoving == 0 )
-      {
-        WorkString = receiveString.substring(3, receiveString.length() - 1);
-        long pos = (long)WorkString.toInt() + (long)driverboard->getposition();
-        pos  = (pos < 0) ? 0 : pos;
-        ftargetPosition = ( pos > (long)mySetupData->get_maxstep()) ? mySetupData->get_maxstep() : (unsigned long)pos;
-      }
-      break;
-    case 65:  // Set jogging state enable/disable
-      // ignore
-      break;
-    case 66:  // Get jogging state enabled/disabled
-      SendPaket('K', 0);
-      break;
-    case 67: // Set jogging direction, 0=IN, 1=OUT
-      // ignore
-      break;
-    case 68:  // Get jogging direction, 0=IN, 1=OUT
-      SendPaket('V', 0);
-      break;
-    case 69:  // RETIRED (sets EEPROMWRITES to 0. Do this one time only when first setting up focuser)
-      break;
-    case 70:  // RETIRED (gets number of EEPROMWrites so far, Nano up to 10,000)
-      SendPaket('W', 0);
-      break;
-    case 71: // set DelayAfterMove in milliseconds
-      WorkString = receiveString.substring(3, receiveString.length() - 1);
-      mySetupData->set_DelayAfterMove((byte)WorkString.toInt());
-      break;
-    case 72: // get DelayAfterMove
-      SendPaket('3', mySetupData->get_DelayAfterMove());
-      break;
-    case 73: // Disable/enable backlash IN (going to lower focuser position)
-      mySetupData->set_backlash_in_enabled((byte) (receiveString[3] - '0'));
-      break;
-    case 74: // get backlash in enabled status
-      SendPaket('4', mySetupData->get_backlash_in_enabled());
-      break;
-    case 75: // Disable/enable backlash OUT (going to lower focuser position)
-      mySetupData->set_backlash_out_enabled((byte) (receiveString[3] - '0'));
-      break;
-    case 76: // get backlash OUT enabled status
-      SendPaket('5', mySetupData->get_backlash_out_enabled());
-      break;
-    case 77: // set backlash in steps
-      WorkString = receiveString.substring(3, receiveString.length() - 1);
-      mySetupData->set_backlashsteps_in((byte)WorkString.toInt());
-      break;
-    case 78: // return number of backlash steps IN
-      SendPaket('6', mySetupData->get_backlashsteps_in());
-      break;
-    case 79: // set backlash OUT steps
-      WorkString = receiveString.substring(3, receiveString.length() - 1);
-      mySetupData->set_backlashsteps_out((byte)WorkString.toInt());
-      break;
-    case 80: // return number of backlash steps OUT
-      SendPaket('7', mySetupData->get_backlashsteps_out());
-      break;
-    case 81:  // Get number of backlashmaximum steps
-      SendPaket('8', 400);
-      break;
-    case 82:  // Set backlash maximum steps
-      break;
-    case 83: // get if there is a temperature probe
-      SendPaket('c', tprobe1);
-      break;
-    case 87: // get tc direction
-      SendPaket('k', mySetupData->get_tcdirection());
-      break;
-    case 88: // set tc direction
-      mySetupData->set_tcdirection((byte) (receiveString[3] - '0'));
-      break;
-    case 89:  // Get stepper power (reads from A7) - only valid if circuit is added (1=stepperpower ON)
-      SendPaket('9', 1);
-      break;
-    case 90: // Set preset x [0-9] with position value yyyy [unsigned long]
+}
+
+// :55# get motorspeed delay for current speed setting
+void cmd_getstepdelay(char token)
+{
+  SendPaket(token, driverboard->getstepdelay());
+}
+
+// :56# set motorspeed delay for current speed setting
+void cmd_setstepdelay(char)
+{
+  int newdelay = 1000;
+  newdelay = cmdargint(3);
+  newdelay = (newdelay < 1000) ? 1000 : newdelay;   // ensure it is not too low
+  driverboard->setstepdelay(newdelay);
+  mySetupData->set_motorspeeddelay(newdelay);
+}
+
+// :58# get controller features .. deprecated
+void cmd_getfeatures(char token)
+{
+  SendPaket(token, 0);
+}
+
+// :61# set update of position on lcd when moving (0=disable, 1=enable)
+void cmd_setlcdupdateonmove(char)
+{
+  mySetupData->set_lcdupdateonmove((byte) (cmdbuffer[3] - '0'));
+}
+
+// :62# get update of position on lcd when moving (00=disable, 01=enable)
+void cmd_getlcdupdateonmove(char token)
+{
+  SendPaket(token, mySetupData->get_lcdupdateonmove());
+}
+
+// :63# get status of home position switch (0=off, 1=closed, position 0)
+void cmd_gethpswstate(char token)
+{
+  if ( mySetupData->get_homepositionswitch() == 1)
+  {
+    SendPaket(token, halpinread(HPSWPIN));
+  }
+  else
+  {
+    SendPaket(token, "0");
+  }
+}
+
+// :64# move a specified number of steps
+void cmd_movesteps(char)
+{
+  if ( isMoving == 0 )
+  {
+    long pos = (long)cmdargint(3) + (long)driverboard->getposition();
+    pos  = (pos < 0) ? 0 : pos;
+    ftargetPosition = ( pos > (long)mySetupData->get_maxstep()) ? mySetupData->get_maxstep() : (unsigned long)pos;
+  }
+}
+
+// :66# Get jogging state enabled/disabled
+void cmd_getjogging(char token)
+{
+  SendPaket(token, 0);
+}
+
+// :68# Get jogging direction, 0=IN, 1=OUT
+void cmd_getjogdirection(char token)
+{
+  SendPaket(token, 0);
+}
+
+// :70# RETIRED (gets number of EEPROMWrites so far, Nano up to 10,000)
+void cmd_geteepromwrites(char token)
+{
+  SendPaket(token, 0);
+}
+
+// :71# set DelayAfterMove in milliseconds
+void cmd_setdelayaftermove(char)
+{
+  mySetupData->set_DelayAfterMove((byte)cmdargint(3));
+}
+
+// :72# get DelayAfterMove
+void cmd_getdelayaftermove(char token)
+{
+  SendPaket(token, mySetupData->get_DelayAfterMove());
+}
+
+// :73# Disable/enable backlash IN (going to lower focuser position)
+void cmd_setbacklashinenabled(char)
+{
+  mySetupData->set_backlash_in_enabled((byte) (cmdbuffer[3] - '0'));
+}
+
+// :74# get backlash in enabled status
+void cmd_getbacklashinenabled(char token)
+{
+  SendPaket(token, mySetupData->get_backlash_in_enabled());
+}
+
+// :75# Disable/enable backlash OUT (going to lower focuser position)
+void cmd_setbacklashoutenabled(char)
+{
+  mySetupData->set_backlash_out_enabled((byte) (cmdbuffer[3] - '0'));
+}
+
+// :76# get backlash OUT enabled status
+void cmd_getbacklashoutenabled(char token)
+{
+  SendPaket(token, mySetupData->get_backlash_out_enabled());
+}
+
+// :77# set backlash in steps
+void cmd_setbacklashinsteps(char)
+{
+  mySetupData->set_backlashsteps_in((byte)cmdargint(3));
+}
+
+// :78# return number of backlash steps IN
+void cmd_getbacklashinsteps(char token)
+{
+  SendPaket(token, mySetupData->get_backlashsteps_in());
+}
+
+// :79# set backlash OUT steps
+void cmd_setbacklashoutsteps(char)
+{
+  mySetupData->set_backlashsteps_out((byte)cmdargint(3));
+}
+
+// :80# return number of backlash steps OUT
+void cmd_getbacklashoutsteps(char token)
+{
+  SendPaket(token, mySetupData->get_backlashsteps_out());
+}
+
+// :81# Get number of backlashmaximum steps
+void cmd_getbacklashmax(char token)
+{
+  SendPaket(token, 400);
+}
+
+// :83# get if there is a temperature probe
+void cmd_gettempprobe(char token)
+{
+  SendPaket(token, tprobe1);
+}
+
+#ifdef STEPTIMING
+// :84# get step timing probe, qsamples,mhz,latemax,isrmax;late histogram;isr histogram#  :841# also resets it
+void cmd_getsteptiming(char token)
+{
+  steptiming_t st;
+  driverboard->getsteptiming(&st);
+  char buffer[48 + (STEPTIMINGBINS * 2 * 11)];
+  int len = snprintf(buffer, sizeof(buffer), "%c%lu,%lu,%lu,%lu;", token, (unsigned long) st.samples, (unsigned long) st.mhz,
+                     (unsigned long) st.latemax, (unsigned long) st.isrmax);
+  for ( int i = 0; i < STEPTIMINGBINS; i++ )
+  {
+    len += snprintf(buffer + len, sizeof(buffer) - len, "%lu%c", (unsigned long) st.late[i], (i == (STEPTIMINGBINS - 1)) ? ';' : ',');
+  }
+  for ( int i = 0; i < STEPTIMINGBINS; i++ )
+  {
+    len += snprintf(buffer + len, sizeof(buffer) - len, "%lu%c", (unsigned long) st.isr[i], (i == (STEPTIMINGBINS - 1)) ? EOFSTR : ',');
+  }
+  SendMessage(buffer);
+  if ( cmdbuffer[3] == '1' )
+  {
+    driverboard->resetsteptiming();
+  }
+}
+#endif
+
+// :85# get focuser status, position,ismoving,temperature,target,stepmode,coilpower in one reply
+// so a polling client needs one round trip instead of :00# :01# :06# :39# :29# :11#
+void cmd_getfocuserstatus(char token)
+{
+  if ( binarymode() )
+  {
+    // uint32 position, uint8 ismoving, float temperature, uint32 target, uint8 stepmode, uint8 coilpower
+    uint8_t rec[15];
+    uint32_t pos = driverboard->getposition();
+    uint32_t target = ftargetPosition;
+    memcpy(rec, &pos, 4);
+    rec[4] = isMoving;
+    memcpy(rec + 5, &lasttemp, 4);
+    memcpy(rec + 9, &target, 4);
+    rec[13] = (uint8_t) mySetupData->get_stepmode();
+    rec[14] = (uint8_t) mySetupData->get_coilpower();
+    SendFrame(BIN_STATUS, rec, sizeof(rec));
+    return;
+  }
+  char temp[16];
+  char buffer[80];
+  dtostrf(lasttemp, 4, 3, temp);
+  snprintf(buffer, sizeof(buffer), "%c%lu,%d,%s,%lu,%d,%d%c", token, (unsigned long) driverboard->getposition(), (int) isMoving, temp,
+           (unsigned long) ftargetPosition, (int) mySetupData->get_stepmode(), (int) mySetupData->get_coilpower(), EOFSTR);
+  SendMessage(buffer);
+}
+
+// :86xxxx# subscribe to move notifications, position frame every xxxx steps while moving, 0 unsubscribes
+void cmd_setnotify(char)
+{
+  long interval = cmdargint(3);
+#if defined(ACCESSPOINT) || defined(STATIONMODE)
+  notify_t *n = &tcpclients[currentclient].notify;
+#else
+  notify_t *n = &notify;
+#endif
+  n->interval = (interval < 0) ? 0 : interval;
+  n->last = driverboard->getposition();
+}
+
+#if defined(ACCESSPOINT) || defined(STATIONMODE)
+// :59x# binary frames for this client, 1 on 0 off, see ESP_BinaryRx()
+void cmd_setbinarymode(char)
+{
+  tcpclients[currentclient].binary = (cmdbuffer[3] == '1');
+}
+#endif
+
+// :87# get tc direction
+void cmd_gettcdirection(char token)
+{
+  SendPaket(token, mySetupData->get_tcdirection());
+}
+
+// :88# set tc direction
+void cmd_settcdirection(char)
+{
+  mySetupData->set_tcdirection((byte) (cmdbuffer[3] - '0'));
+}
+
+// :89# Get stepper power (reads from A7) - only valid if circuit is added (1=stepperpower ON)
+void cmd_getstepperpower(char token)
+{
+  SendPaket(token, 1);
+}
+
+// :90# Set preset x [0-9] with position value yyyy [unsigned long]
+void cmd_setpreset(char)
+{
+  byte preset = (byte) (cmdbuffer[3] - '0');
+  preset = (preset > 9) ? 9 : preset;
+  unsigned long tmppos = (unsigned long)cmdargint(4);
+  mySetupData->set_focuserpreset( preset, tmppos );
+}
+
+// :91# get focuserpreset [0-9]
+void cmd_getpreset(char token)
+{
+  byte preset = (byte) (cmdbuffer[3] - '0');
+  preset = (preset > 9) ? 9 : preset;
+  SendPaket(token, mySetupData->get_focuserpreset(preset));
+}
+
+// :92# Set OLED page display option
+void cmd_setoledpageoption(char)
+{
+  mySetupData->set_oledpageoption(cmdbuffer + 3);
+}
+
+// :93# get OLED page display option
+void cmd_getoledpageoption(char token)
+{
+  char tempbuff[5];
+  mySetupData->get_oledpageoption().toCharArray(tempbuff, mySetupData->get_oledpageoption().length() + 1);
+  SendPaket(token, tempbuff);
+}
+
+// :95# Get DelayedDisplayUpdate (0=disabled, 1-enabled)
+void cmd_getdelayeddisplay(char token)
+{
+  SendPaket(token, 0);
+}
+
+// :96# Set management options
+void cmd_setmanagement(char)
+{
+  int option = cmdargint(3);
+  if ( (option & 1) == 1 )
+  {
+    // ascom server start if not already started
+    if ( mySetupData->get_ascomserverstate() == 0)
+    {
+#if defined(ACCESSPOINT) || defined(STATIONMODE)
+      start_ascomremoteserver();
+#endif
+    }
+  }
+  else
+  {
+    // ascom server stop if running
+    if ( mySetupData->get_ascomserverstate() == 1)
+    {
+#if defined(ACCESSPOINT) || defined(STATIONMODE)
+      stop_ascomremoteserver();
+#endif
+    }
+  }
+  if ( (option & 2) == 2)
+  {
+    // in out leds start
+    if ( mySetupData->get_inoutledstate() == 0)
+    {
+      mySetupData->set_inoutledstate(1);
+      // reinitialise pins
+#if (DRVBRD == PRO2ESP32ULN2003 || DRVBRD == PRO2ESP32L298N || DRVBRD == PRO2ESP32L293DMINI || DRVBRD == PRO2ESP32L9110S) || (DRVBRD == PRO2ESP32DRV8825 )
+      init_leds();
+#endif
+    }
+  }
+  else
+  {
+    // in out leds stop
+    // if disabled then enable
+    if ( mySetupData->get_inoutledstate() == 1)
+    {
+      mySetupData->set_inoutledstate(0);
+    }
+  }
+  if ( (option & 4) == 4)
+  {
+    // temp probe start
+    if (mySetupData->get_temperatureprobestate() == 0)          // if temp probe disabled
+    {
+      mySetupData->set_temperatureprobestate(1);                // then enable probe
+      if ( tprobe1 == 0 )                                       // if probe not started
       {
-        byte preset = (byte) (receiveString[3] - '0');
-        preset = (preset > 9) ? 9 : preset;
-        WorkString = receiveString.substring(4, receiveString.length() - 1);
-        unsigned long tmppos = (unsigned long)WorkString.toInt();
-        mySetupData->set_focuserpreset( preset, tmppos );
+        myTempProbe = new TempProbe();                          // start a new probe
       }
-      break;
-    case 91: // get focuserpreset [0-9]
+      else
       {
-        byte preset = (byte) (receiveString[3] - '0');
-        preset = (preset > 9) ? 9 : preset;
-        SendPaket('h', mySetupData->get_focuserpreset(preset));
+        DebugPrintln("Probe already statrted");
       }
-      break;
-    case 92: // Set OLED page display option
-      WorkString = receiveString.substring(3, receiveString.length() - 1);
-      mySetupData->set_oledpageoption(WorkString);
-      break;
-    case 93: // get OLED page display option
+    }
+  }
+  else
+  {
+    // temp probe stop
+    if (mySetupData->get_temperatureprobestate() == 1)          // if probe currently enabled
+    {
+      mySetupData->set_temperatureprobestate(0);                // then disable it
+      if ( tprobe1 != 0 )                                       // only call this if a probe was found
       {
-        char tempbuff[5];
-        mySetupData->get_oledpageoption().toCharArray(tempbuff, mySetupData->get_oledpageoption().length() + 1);
-        SendPaket('l', tempbuff);
+        myTempProbe->stop_temp_probe();                         // else an exception will occur
       }
-      break;
-    case 94:  // Set DelayedDisplayUpdate (0=disabled, 1-enabled)
-      break;
-    case 95:  // Get DelayedDisplayUpdate (0=disabled, 1-enabled)
-      SendPaket('n', 0);
-      break;
-    case 96: // Set management options
-      {
-        WorkString = receiveString.substring(3, receiveString.length() - 1);
-        int option = WorkString.toInt();
-        if ( (option & 1) == 1 )
-        {
-          // ascom server start if not already started
-          if ( mySetupData->get_ascomserverstate() == 0)
-          {
+    }
+  }
+  if ( (option & 8) == 8 )
+  {
+    // set web server option
+    if ( mySetupData->get_webserverstate() == 0)
+    {
 #if defined(ACCESSPOINT) || defined(STATIONMODE)
-            start_ascomremoteserver();
+      start_webserver();
 #endif
-          }
-        }
-        else
-        {
-          // ascom server stop if running
-          if ( mySetupData->get_ascomserverstate() == 1)
-          {
+    }
+  }
+  else
+  {
+    if ( mySetupData->get_webserverstate() == 1)
+    {
 #if defined(ACCESSPOINT) || defined(STATIONMODE)
-            stop_ascomremoteserver();
+      stop_webserver();
 #endif
-          }
-        }
-        if ( (option & 2) == 2)
-        {
-          // in out leds start
-          if ( mySetupData->get_inoutledstate() == 0)
-          {
-            mySetupData->set_inoutledstate(1);
-            // reinitialise pins
-#if (DRVBRD == PRO2ESP32ULN2003 || DRVBRD == PRO2ESP32L298N || DRVBRD == PRO2ESP32L293DMINI || DRVBRD == PRO2ESP32L9110S) || (DRVBRD == PRO2ESP32DRV8825 )
-            init_leds();
+    }
+  }
+}
+
+// :97# get management option
+void cmd_getmanagement(char token)
+{
+  int option = 0;
+  if ( mySetupData->get_ascomserverstate() == 1)
+  {
+    option += 1;
+  }
+  if ( mySetupData->get_inoutledstate() == 1 )
+  {
+    option += 2;
+  }
+  if (mySetupData->get_temperatureprobestate() == 1)
+  {
+    option += 4;
+  }
+  if ( mySetupData->get_webserverstate() == 1)
+  {
+    option += 8;
+  }
+  SendPaket(token, option);
+}
+
+// :98# get network strength dbm
+void cmd_getrssi(char token)
+{
+  long rssi = getrssi();
+  SendPaket(token, rssi);
+}
+
+// :99# set homepositonswitch state, 0 or 1
+void cmd_sethpswenabled(char)
+{
+  int enablestate = 0;
+  enablestate = cmdargint(3);
+  mySetupData->set_homepositionswitch(enablestate);
+  if( enablestate == 1 )
+  {
+    init_homepositionswitch();
+  }
+}
+
+// ---------------------------------------------------------------------------
+// COMMAND TABLE
+// ---------------------------------------------------------------------------
+enum cmdargtype { CMDARG_NONE, CMDARG_DIGIT, CMDARG_INT, CMDARG_FLOAT, CMDARG_TEXT };
+
+struct cmdentry_t
+{
+  byte opcode;
+  void (*handler)(char);                        // nullptr if the opcode is not supported
+  char token;                                   // reply token, 0 if the command does not reply
+  byte argtype;                                 // argument after the opcode, checked before the handler is called
+};
+
+// indexed by opcode, an opcode is looked up once and rejected if its entry has no handler
+constexpr cmdentry_t cmdtable[CMDTABLESIZE] =
+{
+  {  0, cmd_getposition,             'P', CMDARG_NONE   },
+  {  1, cmd_getismoving,             'I', CMDARG_NONE   },
+  {  2, cmd_getstatus,               'E', CMDARG_NONE   },
+  {  3, cmd_getversion,              'F', CMDARG_NONE   },
+  {  4, cmd_getname,                 'F', CMDARG_NONE   },
+  {  5, cmd_movetoposition,          0,   CMDARG_INT    },
+  {  6, cmd_gettemperature,          'Z', CMDARG_NONE   },
+  {  7, cmd_setmaxstep,              0,   CMDARG_INT    },
+  {  8, cmd_getmaxstep,              'M', CMDARG_NONE   },
+  {  9, nullptr,                     0,   CMDARG_NONE   },
+  { 10, cmd_getmaxincrement,         'Y', CMDARG_NONE   },
+  { 11, cmd_getcoilpower,            'O', CMDARG_NONE   },
+  { 12, cmd_setcoilpower,            0,   CMDARG_DIGIT  },
+  { 13, cmd_getreverse,              'R', CMDARG_NONE   },
+  { 14, cmd_setreverse,              0,   CMDARG_DIGIT  },
+  { 15, cmd_setmotorspeed,           0,   CMDARG_INT    },
+  { 16, cmd_setcelsius,              0,   CMDARG_NONE   },
+  { 17, cmd_setfahrenheit,           0,   CMDARG_NONE   },
+  { 18, cmd_setstepsizeenabled,      0,   CMDARG_DIGIT  },
+  { 19, cmd_setstepsize,             0,   CMDARG_FLOAT  },
+  { 20, cmd_settempresolution,       0,   CMDARG_INT    },
+  { 21, cmd_gettempresolution,       'Q', CMDARG_NONE   },
+  { 22, cmd_settempcoefficient,      0,   CMDARG_INT    },
+  { 23, cmd_settempcompenabled,      0,   CMDARG_DIGIT  },
+  { 24, cmd_gettempcompenabled,      '1', CMDARG_NONE   },
+  { 25, cmd_gettempcompavailable,    'A', CMDARG_NONE   },
+  { 26, cmd_gettempcoefficient,      'B', CMDARG_NONE   },
+  { 27, cmd_halt,                    0,   CMDARG_NONE   },
+  { 28, cmd_home,                    0,   CMDARG_NONE   },
+  { 29, cmd_getstepmode,             'S', CMDARG_NONE   },
+  { 30, cmd_setstepmode,             0,   CMDARG_INT    },
+  { 31, cmd_setposition,             0,   CMDARG_INT    },
+  { 32, cmd_getstepsizeenabled,      'U', CMDARG_NONE   },
+  { 33, cmd_getstepsize,             'T', CMDARG_NONE   },
+  { 34, cmd_getlcdpagetime,          'X', CMDARG_NONE   },
+  { 35, cmd_setlcdpagetime,          0,   CMDARG_INT    },
+  { 36, cmd_setdisplayenabled,       0,   CMDARG_DIGIT  },
+  { 37, cmd_getdisplayenabled,       'D', CMDARG_NONE   },
+  { 38, cmd_gettempmode,             'b', CMDARG_NONE   },
+  { 39, cmd_gettargetposition,       'N', CMDARG_NONE   },
+  { 40, cmd_reboot,                  0,   CMDARG_NONE   },
+  { 41, cmd_none,                    0,   CMDARG_NONE   },
+  { 42, cmd_setdefaults,             0,   CMDARG_NONE   },
+  { 43, cmd_getmotorspeed,           'C', CMDARG_NONE   },
+  { 44, cmd_none,                    0,   CMDARG_NONE   },
+  { 45, cmd_getspeedthreshold,       'G', CMDARG_NONE   },
+  { 46, cmd_none,                    0,   CMDARG_NONE   },
+  { 47, cmd_getspeedchange,          'J', CMDARG_NONE   },
+  { 48, cmd_savesettings,            0,   CMDARG_NONE   },
+  { 49, cmd_getid,                   'a', CMDARG_NONE   },
+  { 50, cmd_gethpswenabled,          'l', CMDARG_NONE   },
+  { 51, cmd_getipaddress,            'd', CMDARG_NONE   },
+  { 52, cmd_getpacketssent,          'e', CMDARG_NONE   },
+  { 53, cmd_getpacketsreceived,      'f', CMDARG_NONE   },
+  { 54, cmd_getssid,                 'g', CMDARG_NONE   },
+  { 55, cmd_getstepdelay,            '0', CMDARG_NONE   },
+  { 56, cmd_setstepdelay,            0,   CMDARG_INT    },
+  { 57, cmd_none,                    0,   CMDARG_NONE   },
+  { 58, cmd_getfeatures,             'm', CMDARG_NONE   },
+#if defined(ACCESSPOINT) || defined(STATIONMODE)
+  { 59, cmd_setbinarymode,           0,   CMDARG_DIGIT  },
+#else
+  { 59, nullptr,                     0,   CMDARG_NONE   },
 #endif
-          }
-        }
-        else
-        {
-          // in out leds stop
-          // if disabled then enable
-          if ( mySetupData->get_inoutledstate() == 1)
-          {
-            mySetupData->set_inoutledstate(0);
-          }
-        }
-        if ( (option & 4) == 4)
+  { 60, cmd_none,                    0,   CMDARG_NONE   },
+  { 61, cmd_setlcdupdateonmove,      0,   CMDARG_DIGIT  },
+  { 62, cmd_getlcdupdateonmove,      'L', CMDARG_NONE   },
+  { 63, cmd_gethpswstate,            'H', CMDARG_NONE   },
+  { 64, cmd_movesteps,               0,   CMDARG_INT    },
+  { 65, cmd_none,                    0,   CMDARG_NONE   },
+  { 66, cmd_getjogging,              'K', CMDARG_NONE   },
+  { 67, cmd_none,                    0,   CMDARG_NONE   },
+  { 68, cmd_getjogdirection,         'V', CMDARG_NONE   },
+  { 69, cmd_none,                    0,   CMDARG_NONE   },
+  { 70, cmd_geteepromwrites,         'W', CMDARG_NONE   },
+  { 71, cmd_setdelayaftermove,       0,   CMDARG_INT    },
+  { 72, cmd_getdelayaftermove,       '3', CMDARG_NONE   },
+  { 73, cmd_setbacklashinenabled,    0,   CMDARG_DIGIT  },
+  { 74, cmd_getbacklashinenabled,    '4', CMDARG_NONE   },
+  { 75, cmd_setbacklashoutenabled,   0,   CMDARG_DIGIT  },
+  { 76, cmd_getbacklashoutenabled,   '5', CMDARG_NONE   },
+  { 77, cmd_setbacklashinsteps,      0,   CMDARG_INT    },
+  { 78, cmd_getbacklashinsteps,      '6', CMDARG_NONE   },
+  { 79, cmd_setbacklashoutsteps,     0,   CMDARG_INT    },
+  { 80, cmd_getbacklashoutsteps,     '7', CMDARG_NONE   },
+  { 81, cmd_getbacklashmax,          '8', CMDARG_NONE   },
+  { 82, cmd_none,                    0,   CMDARG_NONE   },
+  { 83, cmd_gettempprobe,            'c', CMDARG_NONE   },
+#ifdef STEPTIMING
+  { 84, cmd_getsteptiming,           'q', CMDARG_NONE   },
+#else
+  { 84, nullptr,                     0,   CMDARG_NONE   },
+#endif
+  { 85, cmd_getfocuserstatus,        'i', CMDARG_NONE   },
+  { 86, cmd_setnotify,               0,   CMDARG_INT    },
+  { 87, cmd_gettcdirection,          'k', CMDARG_NONE   },
+  { 88, cmd_settcdirection,          0,   CMDARG_DIGIT  },
+  { 89, cmd_getstepperpower,         '9', CMDARG_NONE   },
+  { 90, cmd_setpreset,               0,   CMDARG_INT    },
+  { 91, cmd_getpreset,               'h', CMDARG_DIGIT  },
+  { 92, cmd_setoledpageoption,       0,   CMDARG_TEXT   },
+  { 93, cmd_getoledpageoption,       'l', CMDARG_NONE   },
+  { 94, cmd_none,                    0,   CMDARG_NONE   },
+  { 95, cmd_getdelayeddisplay,       'n', CMDARG_NONE   },
+  { 96, cmd_setmanagement,           0,   CMDARG_INT    },
+  { 97, cmd_getmanagement,           'o', CMDARG_NONE   },
+  { 98, cmd_getrssi,                 's', CMDARG_NONE   },
+  { 99, cmd_sethpswenabled,          0,   CMDARG_INT    }
+};
+
+constexpr bool cmdtableok(int i)
+{
+  return ( i == CMDTABLESIZE ) || ( (cmdtable[i].opcode == i) && cmdtableok(i + 1) );
+}
+
+static_assert(cmdtableok(0), "cmdtable entries must be at the index of their opcode");
+
+// true if the frame in cmdbuffer has the argument the command expects
+bool cmdargok(byte argtype)
+{
+  char c = cmdbuffer[3];
+  switch ( argtype )
+  {
+    case CMDARG_NONE:
+      return true;
+    case CMDARG_DIGIT:
+      return isdigit(c);
+    case CMDARG_INT:
+      return isdigit(c) || (c == '-');
+    case CMDARG_FLOAT:
+      return isdigit(c) || (c == '-') || (c == '.');
+    default:
+      return (c != 0);
+  }
+}
+
+// run the command in cmdbuffer, false if it was not accepted
+bool ESP_Dispatch()
+{
+  byte cmdval;
+
+  cmdval = cmdnumber();                                   // convert command to an integer
+  DebugPrint("recstr=");
+  DebugPrint(cmdbuffer);
+  DebugPrint("  cmdstr=");
+  DebugPrintln(cmdval);
+  if ( (cmdval >= CMDTABLESIZE) || (cmdtable[cmdval].handler == nullptr) || !cmdargok(cmdtable[cmdval].argtype) )
+  {
+    DebugPrintln("unknown cmd");
+    return false;
+  }
+  cmdopcode = cmdval;
+  cmdtable[cmdval].handler(cmdtable[cmdval].token);
+  return true;
+}
+
+#if defined(ACCESSPOINT) || defined(STATIONMODE)
+// binary request, BINSYNC opcode type lenlo lenhi payload crclo crchi, same layout as SendFrame()
+// the payload is written back into cmdbuffer as the :xxyyyy argument so every opcode keeps its
+// meaning, the reply comes back as a binary frame from SendPaket(). Bad frames get a BIN_ERROR reply
+void ESP_BinaryRx(tcpclient_t *tc, uint8_t c)
+{
+  uint8_t *frame = (uint8_t *) tc->frame;
+
+  if ( (tc->framelen == 0) && (c != BINSYNC) )
+  {
+    return;                                               // look for the start of a frame
+  }
+  frame[tc->framelen++] = c;
+  if ( tc->framelen < BINHEADERSIZE )
+  {
+    return;
+  }
+  int len = frame[3] | (frame[4] << 8);
+  if ( len > BINPAYLOADMAX )
+  {
+    tc->framelen = 0;                                     // not a frame, look for the next BINSYNC
+    return;
+  }
+  if ( tc->framelen < (BINHEADERSIZE + len + 2) )
+  {
+    return;
+  }
+  tc->framelen = 0;
+  packetsreceived++;
+
+  byte opcode = frame[1];
+  byte type = frame[2];
+  const uint8_t *payload = frame + BINHEADERSIZE;
+  uint16_t crc = payload[len] | (payload[len + 1] << 8);
+  char *arg = cmdbuffer + 3;
+  bool ok = (crc == crc16(0xFFFF, frame + 1, BINHEADERSIZE - 1 + len)) && (opcode < CMDTABLESIZE);
+  if ( ok )
+  {
+    cmdbuffer[0] = STARTCMDSTR;
+    cmdbuffer[1] = '0' + (opcode / 10);
+    cmdbuffer[2] = '0' + (opcode % 10);
+    arg[0] = 0;
+    switch ( type )
+    {
+      case BIN_NONE:
+        ok = (len == 0);
+        break;
+      case BIN_U8:
+        ok = (len == 1);
+        ultoa(payload[0], arg, 10);
+        break;
+      case BIN_I32:
+      case BIN_U32:
+        ok = (len == 4);
+        if ( ok )
         {
-          // temp probe start
-          if (mySetupData->get_temperatureprobestate() == 0)          // if temp probe disabled
+          uint32_t val;
+          memcpy(&val, payload, 4);
+          if ( type == BIN_I32 )
           {
-            mySetupData->set_temperatureprobestate(1);                // then enable probe
-            if ( tprobe1 == 0 )                                       // if probe not started
-            {
-              myTempProbe = new TempProbe();                          // start a new probe
-            }
-            else
-            {
-              DebugPrintln("Probe already statrted");
-            }
+            ltoa((int32_t) val, arg, 10);
           }
-        }
-        else
-        {
-          // temp probe stop
-          if (mySetupData->get_temperatureprobestate() == 1)          // if probe currently enabled
+          else
           {
-            mySetupData->set_temperatureprobestate(0);                // then disable it
-            if ( tprobe1 != 0 )                                       // only call this if a probe was found
-            {
-              myTempProbe->stop_temp_probe();                         // else an exception will occur
-            }
+            ultoa(val, arg, 10);
           }
         }
-        if ( (option & 8) == 8 )
+        break;
+      case BIN_F32:
+        ok = (len == 4);
+        if ( ok )
         {
-          // set web server option
-          if ( mySetupData->get_webserverstate() == 0)
-          {
-#if defined(ACCESSPOINT) || defined(STATIONMODE)
-            start_webserver();
-#endif
-          }
+          float val;
+          memcpy(&val, payload, 4);
+          dtostrf(val, 1, 6, arg);
         }
-        else
-        {
-          if ( mySetupData->get_webserverstate() == 1)
-          {
-#if defined(ACCESSPOINT) || defined(STATIONMODE)
-            stop_webserver();
+        break;
+      case BIN_TEXT:
+        memcpy(arg, payload, len);
+        arg[len] = 0;
+        break;
+      default:
+        ok = false;
+        break;
+    }
+  }
+  if ( !ok || !ESP_Dispatch() )
+  {
+    cmdopcode = opcode;
+    SendFrame(BIN_ERROR, nullptr, 0);
+  }
+}
 #endif
-          }
-        }
-      }
+
+// run every complete frame waiting from the client, replies go out in one write at the end
+// for tcp this serves tcpclients[currentclient], reading at most TCPRXBUDGET bytes
+void ESP_Communication()
+{
+#if defined(BLUETOOTHMODE) || defined(LOCALSERIAL)
+  while ( queue.count() >= 1 )
+  {
+    cmdbuffer[0] = STARTCMDSTR;
+    memcpy(cmdbuffer + 1, queue.peek(), CMDBUFFERSIZE - 1);
+    queue.pop();
+    ESP_Dispatch();
+  }
+#else   // for Accesspoint or Station mode
+  tcpclient_t *tc = &tcpclients[currentclient];
+  uint8_t rxbuffer[64];
+  int budget = TCPRXBUDGET;
+  int avail;
+  while ( (budget > 0) && ((avail = tc->client.available()) > 0) )
+  {
+    avail = (avail < budget) ? avail : budget;
+    int n = tc->client.read(rxbuffer, (avail < (int) sizeof(rxbuffer)) ? avail : sizeof(rxbuffer));
+    if ( n <= 0 )
+    {
       break;
-    case 97: // get management option
+    }
+    budget -= n;
+    for ( int i = 0; i < n; i++ )
+    {
+      if ( tc->binary )
       {
-        int option = 0;
-        if ( mySetupData->get_ascomserverstate() == 1)
-        {
-          option += 1;
-        }
-        if ( mySetupData->get_inoutledstate() == 1 )
-        {
-          option += 2;
-        }
-        if (mySetupData->get_temperatureprobestate() == 1)
-        {
-          option += 4;
-        }
-        if ( mySetupData->get_webserverstate() == 1)
+        ESP_BinaryRx(tc, rxbuffer[i]);
+        continue;
+      }
+      char c = (char) rxbuffer[i];
+      if ( c == STARTCMDSTR )                             // a new frame, drop anything before it
+      {
+        tc->framelen = 0;
+        tc->overflow = false;
+      }
+      if ( c == EOFSTR )
+      {
+        if ( !tc->overflow )
         {
-          option += 8;
+          memcpy(cmdbuffer, tc->frame, tc->framelen);
+          cmdbuffer[tc->framelen] = 0;
+          packetsreceived++;
+          ESP_Dispatch();
         }
-        SendPaket('o', option);
+        tc->framelen = 0;
+        tc->overflow = false;
       }
-      break;
-    case 98:  // get network strength dbm
+      else if ( tc->framelen < (CMDBUFFERSIZE - 1) )
+      {
+        tc->frame[tc->framelen++] = c;
+      }
+      else
+      {
+        tc->overflow = true;
+      }
+    }
+  }
+  FlushReplies();
+#endif
+}
+
+#if defined(ACCESSPOINT) || defined(STATIONMODE)
+// accept new clients, drop closed ones and serve each connected client once, returns the number connected
+byte ESP_TCPClients()
+{
+  byte count = 0;
+
+  haltcpclient_t newclient = myserver.available();
+  if ( newclient )
+  {
+    int slot = -1;
+    for ( int i = 0; i < MAXTCPCLIENTS; i++ )
+    {
+      if ( !tcpclients[i].client.connected() )
+      {
+        slot = i;
+        break;
+      }
+    }
+    if ( slot == -1 )
+    {
+      DebugPrintln(TCPCLIENTREFUSEDSTR);
+      newclient.stop();
+    }
+    else
+    {
+      DebugPrintln(TCPCLIENTCONNECTSTR);
+      tcpclients[slot].client.stop();
+      tcpclients[slot].client = newclient;
+      tcpclients[slot].framelen = 0;
+      tcpclients[slot].overflow = false;
+      tcpclients[slot].notify.interval = 0;
+      tcpclients[slot].binary = false;
+    }
+  }
+
+  for ( int i = 0; i < MAXTCPCLIENTS; i++ )
+  {
+    currentclient = (firstclient + i) % MAXTCPCLIENTS;
+    tcpclient_t *tc = &tcpclients[currentclient];
+    if ( tc->client.connected() )
+    {
+      count++;
+      if ( tc->client.available() )
+      {
+        ESP_Communication();
+      }
+    }
+    else if ( tc->client )
+    {
+      DebugPrintln(TCPCLIENTDISCONNECTSTR);
+      tc->client.stop();
+    }
+  }
+  firstclient = (firstclient + 1) % MAXTCPCLIENTS;
+  return count;
+}
+#endif
+#endif // if defined(ACCESSPOINT) || defined(STATIONMODE) || defined(LOCALSERIAL) || defined(BLUETOOTHMODE)
+
+// true if the subscriber wants this event, NOTIFYPOSITION is only sent once the focuser has moved interval steps
+bool notifywanted(notify_t *n, byte event, unsigned long pos)
+{
+  if ( n->interval <= 0 )
+  {
+    return false;
+  }
+  if ( event == NOTIFYPOSITION )
+  {
+    unsigned long moved = (pos > n->last) ? (pos - n->last) : (n->last - pos);
+    if ( moved < (unsigned long) n->interval )
+    {
+      return false;
+    }
+  }
+  n->last = pos;
+  return true;
+}
+
+// build the j<event>,<position># frame in buffer
+void notifyframe(char *buffer, size_t len, byte event, unsigned long pos)
+{
+  snprintf(buffer, len, "%c%d,%lu%c", NOTIFYTOKEN, (int) event, pos, EOFSTR);
+  cmdopcode = 86;                                         // binary clients get the frame as BIN_TEXT on opcode 86
+}
+
+// push j<event>,<position># to every subscribed client, called by the loop() state machine. NOTIFYPOSITION
+// comes on every State_Moving pass, so the frame is only built once a subscriber wants it
+void ESP_Notify(byte event)
+{
+  unsigned long pos = driverboard->getposition();
+  char buffer[24];
+  buffer[0] = 0;
+#if defined(ACCESSPOINT) || defined(STATIONMODE)
+  byte client = currentclient;
+  for ( currentclient = 0; currentclient < MAXTCPCLIENTS; currentclient++ )
+  {
+    tcpclient_t *tc = &tcpclients[currentclient];
+    if ( (tc->notify.interval > 0) && tc->client.connected() && notifywanted(&tc->notify, event, pos) )
+    {
+      if ( buffer[0] == 0 )
       {
-        long rssi = getrssi();
-        SendPaket('s', rssi);
+        notifyframe(buffer, sizeof(buffer), event, pos);
       }
+      SendMessage(buffer);
+      FlushReplies();
+    }
+  }
+  currentclient = client;
+#elif defined(LOCALSERIAL) || defined(BLUETOOTHMODE)
+  if ( notifywanted(&notify, event, pos) )
+  {
+    notifyframe(buffer, sizeof(buffer), event, pos);
+    SendMessage(buffer);
+  }
+#endif
+}
+
+#if defined(LOCALSERIAL) || defined(BLUETOOTHMODE)
+// build a command line one char at a time in the queue slot
+// : starts the command, # ends the command, do not store these in the command buffer
+// :27# sets halt_alert as soon as the # arrives instead of waiting in the queue for loop()
+void processrxchar(char inChar)
+{
+  static byte rxlen = 0;                       // chars in the command so far
+  static bool rxhalt = false;                  // command so far is 27
+
+  switch ( inChar )
+  {
+    case STARTCMDSTR :     // start
+      queue.clearframe();
+      rxlen = 0;
+      rxhalt = false;
+      break;
+    case '\r' :
+    case '\n' :
+      // ignore
       break;
-    case 99:  // set homepositonswitch state, 0 or 1
+    case EOFSTR :       // eoc
+      if ( rxhalt && (rxlen == 2) )
       {
-        int enablestate = 0;
-        WorkString = receiveString.substring(3, receiveString.length() - 1);
-        enablestate = WorkString.toInt();
-        mySetupData->set_homepositionswitch(enablestate);
-        if( enablestate == 1 )
-        {
-          init_homepositionswitch();
-        }
+        halt_alert = true;
+        queue.clearframe();
+      }
+      else
+      {
+        queue.pushframe();
       }
+      rxlen = 0;
+      rxhalt = false;
+      break;
+    default :           // anything else
+      rxhalt = (rxlen == 0) ? (inChar == '2') : (rxhalt && (rxlen == 1) && (inChar == '7'));
+      rxlen++;
+      queue.addframe(inChar);
       break;
   }
 }
-#endif // if defined(ACCESSPOINT) || defined(STATIONMODE) || defined(LOCALSERIAL) || defined(BLUETOOTHMODE)
+#endif
 
 #if defined(LOCALSERIAL)
 void clearSerialPort()
@@ -736,28 +1627,9 @@ void clearSerialPort()
 
 void processserial()
 {
-  // Serial.read() only returns a single char so build a command line one char at a time
-  // : starts the command, # ends the command, do not store these in the command buffer
-  // read the command until the terminating # character
   while (Serial.available() )
   {
-    char inChar = Serial.read();
-    switch ( inChar )
-    {
-      case STARTCMDSTR :     // start
-        serialline = "";
-        break;
-      case '\r' :
-      case '\n' :
-        // ignore
-        break;
-      case EOFSTR :       // eoc
-        queue.push(serialline);
-        break;
-      default :           // anything else
-        serialline = serialline + inChar;
-        break;
-    }
+    processrxchar(Serial.read());
   }
 }
 #endif // if defined(LOCALSERIAL)
@@ -773,31 +1645,34 @@ void clearbtPort()
 
 void processbt()
 {
-  // SerialBT.read() only returns a single char so build a command line one char at a time
-  // : starts the command, # ends the command, do not store these in the command buffer
-  // read the command until the terminating # character
   while (SerialBT.available() )
   {
-    char inChar = SerialBT.read();
-    switch ( inChar )
-    {
-      case STARTCMDSTR :     // start
-        btline = "";
-        break;
-      case '\r' :
-      case '\n' :
-        // ignore
-        break;
-      case EOFSTR :       // eoc
-        queue.push(btline);
-        break;
-      default :           // anything else
-        btline = btline + inChar;
-        break;
-    }
+    processrxchar(SerialBT.read());
   }
 }
 #endif // if defined(BLUETOOTHMODE)
 
+#if defined(ESP32) && (defined(LOCALSERIAL) || defined(BLUETOOTHMODE))
+// receive task, reads the port every tick so commands (and halt) are taken while loop() is busy
+// this task is the only producer for queue, loop() is the only consumer
+void commsrxtask(void *)
+{
+  for (;;)
+  {
+#if defined(LOCALSERIAL)
+    processserial();
+#else
+    processbt();
+#endif
+    vTaskDelay(1);
+  }
+}
+
+void start_commsrxtask()
+{
+  xTaskCreate(commsrxtask, "commsrx", COMMSRXSTACKSIZE, NULL, COMMSRXPRIORITY, NULL);
+}
+#endif
+
 
 #endif
@@ -0,0 +1,33 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP CRC-16
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+// CRC-16/CCITT (poly 0x1021), start with 0xFFFF. Used by the binary protocol frames in comms.h and
+// the position journal in FocuserSetupData.cpp. Bitwise so it needs no table in RAM.
+
+#ifndef crc16_h
+#define crc16_h
+
+#include <stdint.h>
+
+inline uint16_t crc16(uint16_t crc, const uint8_t *data, int len)
+{
+  while ( len-- )
+  {
+    crc ^= (uint16_t) (*data++) << 8;
+    for ( int i = 0; i < 8; i++ )
+    {
+      crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+    }
+  }
+  return crc;
+}
+
+#endif
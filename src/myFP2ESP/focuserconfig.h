@@ -14,6 +14,9 @@
 #ifndef focuserconfig_h
 #define focuserconfig_h
 
+// the host build (Test-Programs/HOSTBUILD) sets its own controller mode on the compiler command line
+#if !defined(HOSTBUILD)
+
 // ---------------------------------------------------------------------------
 // 1: SPECIFY HARDWARE OPTIONS HERE
 // ---------------------------------------------------------------------------
@@ -110,6 +113,8 @@
 // content in web browser, uncomment the next line
 // This has moved to MANAGEMENT SERVER
 
+#endif // !HOSTBUILD
+
 // ----------------------------------------------------------------------------
 // 3: SPECIFY OLED DISPLAY TYPE
 // ----------------------------------------------------------------------------
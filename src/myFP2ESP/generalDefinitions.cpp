@@ -60,6 +60,7 @@ const char* LOOPSTARTSTR          = "Loop Start =";
 const char* LOOPENDSTR            = "Loop End =";
 const char* TCPCLIENTCONNECTSTR   = "tcp client connected";
 const char* TCPCLIENTDISCONNECTSTR = "tcp client disconnected";
+const char* TCPCLIENTREFUSEDSTR = "tcp client refused, too many clients";
 const char* APCONNECTFAILSTR      = "Did not connect to AP ";
 const char* CONNECTEDSTR          = "Connected";
 const char* I2CDEVICENOTFOUNDSTR  = "I2C device not found";
@@ -97,6 +98,8 @@ const char* HPMOVETILLOPENSTR     = "HP Sw=0, Mov out";
 const char* HPMOVEOUTERRORSTR     = "HP Sw=0, Mov out err";
 const char* HPMOVEOUTFINISHEDSTR  = "HP Sw=0, Mov out ok";
 const char* HPMOVEOUTSTEPSSTR     = "HP Sw, Mov out steps:";
+const char* HPMOVETILLCLOSEDSTR   = "HP Sw=1, Mov in";
+const char* HPMOVEINERRORSTR      = "HP Sw=1, Mov in err";
 
 // oled messages
 const char* CURRENTPOSSTR       =  "Current Pos = ";
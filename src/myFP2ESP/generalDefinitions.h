@@ -21,7 +21,7 @@
 enum oled_state { oled_off, oled_on };
 enum connection_status { disconnected, connected };
 //  StateMachine definition
-enum StateMachineStates { State_Idle, State_InitMove, State_Backlash, State_Moving, State_DelayAfterMove, State_FinishedMove, State_SetHomePosition };
+enum StateMachineStates { State_Idle, State_InitMove, State_Moving, State_DelayAfterMove, State_FinishedMove, State_SetHomePosition, State_HomeBackOff, State_HomeApproach };
 
 #define DEFAULTPOSITION       5000L
 #define DEFAULTMAXSTEPS       80000L
@@ -48,12 +48,18 @@ enum StateMachineStates { State_Idle, State_InitMove, State_Backlash, State_Movi
 
 #define MOTORPULSETIME        2             // DO NOT CHANGE
 #define SERVERPORT            2020          // TCPIP port for myFP2ESP
+#define MAXTCPCLIENTS         4             // tcp clients served at the same time, further connections are refused
 #define TEMPREFRESHRATE       3000L         // refresh rate between temperature conversions unless an update is requested via serial command
 #define SERIALPORTSPEED       115200        // 9600, 14400, 19200, 28800, 38400, 57600, 115200
 #define ESPDATA               0             // command has come from tcp/ip
 #define BTDATA                1             // command has come from bluetooth
 #define SERIALDATA            2             // command has come from serial port
 #define QUEUELENGTH           20            // number of commands that can be saved in the serial queue
+#define COMMSRXSTACKSIZE      2048          // ESP32 serial/bluetooth receive task stack
+#define COMMSRXPRIORITY       2             // above loop() so commands are framed while a move is being set up
+#define SAVETASKSTACKSIZE     4096          // ESP32 settings save task stack
+#define SAVETASKPRIORITY      1             // same as loop(), on the other core so loop() is not held up
+#define SAVETASKCORE          0
 
 #define DEFAULTSTEPSIZE       50.0          // This is the default setting for the step size in microns
 #define MINIMUMSTEPSIZE       0.0
@@ -65,8 +71,6 @@ enum StateMachineStates { State_Idle, State_InitMove, State_Backlash, State_Movi
 #define LCDPAGETIMEMIN        2             // 2s minimum lcd page display time
 #define LCDPAGETIMEMAX        10            // 10s maximum lcd page display time
 #define HOMESTEPS             200           // Prevent searching for home position switch never returning, this should be > than # of steps between closed and open
-#define HPSWOPEN              0             // hpsw states refelect status of switch
-#define HPSWCLOSED            1
 
 #define MAXWEBPAGESIZE        3400
 #define MAXASCOMPAGESIZE      2200
@@ -120,6 +124,28 @@ enum StateMachineStates { State_Idle, State_InitMove, State_Backlash, State_Movi
 
 #define EOFSTR                '#'
 #define STARTCMDSTR           ':'
+#define CMDBUFFERSIZE         64            // longest :xxyyyy frame the comms parser accepts
+#define CMDTABLESIZE          100           // opcodes 00 to 99, see cmdtable in comms.h
+#define REPLYBUFFERSIZE       256           // replies to the tcp frames handled in one loop() pass, sent in one write
+#define TCPRXBUDGET           256           // bytes read from one tcp client per loop() pass so a busy client does not starve the others
+#define NOTIFYTOKEN           'j'           // token of the frames pushed to :86# subscribers, j<event>,<position>#
+#define NOTIFYMOVESTART       0
+#define NOTIFYPOSITION        1
+#define NOTIFYMOVEDONE        2
+#define NOTIFYHALTED          3
+#define NOTIFYHOMED           4
+#define NOTIFYHOMEERROR       5
+#define BINSYNC               0xA5          // first byte of a binary frame, see ESP_BinaryRx() in comms.h
+#define BINHEADERSIZE         5             // sync, opcode, payload type, payload length (2 bytes)
+#define BINPAYLOADMAX         (CMDBUFFERSIZE - BINHEADERSIZE - 2)   // largest request payload, frame ends with a 2 byte crc
+#define BIN_NONE              0             // binary payload types
+#define BIN_U8                1
+#define BIN_I32               2
+#define BIN_U32               3
+#define BIN_F32               4
+#define BIN_TEXT              5
+#define BIN_STATUS            6             // :85# record
+#define BIN_ERROR             7             // bad crc, unknown opcode or wrong payload
 
 extern const char* programVersion;
 extern const char* ProgramAuthor;
@@ -172,6 +198,7 @@ extern const char* LOOPSTARTSTR;
 extern const char* LOOPENDSTR;
 extern const char* TCPCLIENTCONNECTSTR;
 extern const char* TCPCLIENTDISCONNECTSTR;
+extern const char* TCPCLIENTREFUSEDSTR;
 extern const char* APCONNECTFAILSTR;
 extern const char* CONNECTEDSTR;
 extern const char* I2CDEVICENOTFOUNDSTR;
@@ -202,6 +229,8 @@ extern const char* HPMOVETILLOPENSTR;
 extern const char* HPMOVEOUTERRORSTR;
 extern const char* HPMOVEOUTSTEPSSTR;
 extern const char* HPMOVEOUTFINISHEDSTR;
+extern const char* HPMOVETILLCLOSEDSTR;
+extern const char* HPMOVEINERRORSTR;
 
 // temperature probe messages
 extern const char* TPROBESTR;
@@ -411,6 +440,8 @@ DebugPrintln(__PRETTY_FUNCTION__);
 #define TIMEASCOMHANDLEAPIVER       1
 #define TIMEASCOMHANDLEAPIDES       1
 #define TIMEASCOMHANDLEAPICON       1
+
+#define TIMEMOVESTART               1             // :05 received to first step pulse, in uS
 #endif
 
 #endif // generalDefinitions.h
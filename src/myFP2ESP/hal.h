@@ -0,0 +1,96 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP HARDWARE ABSTRACTION
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+// The focuser core (loop() state machine, comms.h, SetupData, temp.cpp) reaches time, GPIO, the
+// file system and the network only through the names below. The motor timer and step generation
+// are behind DriverBoard. On the ESP8266/ESP32 these map straight onto the Arduino core, so there
+// is no cost. A build for another target provides the same names from its own peripherals.
+
+#ifndef hal_h
+#define hal_h
+
+#include <Arduino.h>
+
+#if defined(HOSTBUILD)
+#include "hostsim.h"                            // simulated peripherals, see Test-Programs/HOSTBUILD
+#elif defined(ESP8266)
+#include <FS.h>
+#include <ESP8266WiFi.h>
+#include <ESP8266WebServer.h>
+#else
+#include <SPIFFS.h>
+#include <WiFi.h>
+#include <WebServer.h>
+#endif
+#include <WiFiServer.h>
+#include <WiFiClient.h>
+
+// ---------------------------------------------------------------------------
+// 1: TIME
+// ---------------------------------------------------------------------------
+
+inline unsigned long halmillis(void)
+{
+  return millis();
+}
+
+inline unsigned long halmicros(void)
+{
+  return micros();
+}
+
+inline void haldelay(unsigned long ms)
+{
+  delay(ms);
+}
+
+// ---------------------------------------------------------------------------
+// 2: GPIO
+// ---------------------------------------------------------------------------
+
+inline void halpinmode(uint8_t pin, uint8_t mode)
+{
+  pinMode(pin, mode);
+}
+
+inline int halpinread(uint8_t pin)
+{
+  return digitalRead(pin);
+}
+
+inline void halpinwrite(uint8_t pin, uint8_t val)
+{
+  digitalWrite(pin, val);
+}
+
+// ---------------------------------------------------------------------------
+// 3: FILE SYSTEM
+// ---------------------------------------------------------------------------
+
+// file system holding the setup data files, used as HALFS.open(), HALFS.exists() ...
+#define HALFS             SPIFFS
+
+typedef File halfile_t;
+
+// ---------------------------------------------------------------------------
+// 4: NETWORK
+// ---------------------------------------------------------------------------
+
+typedef WiFiServer haltcpserver_t;              // tcp/ip server for the focuser protocol in comms.h
+typedef WiFiClient haltcpclient_t;
+
+#if defined(ESP8266) || defined(HOSTBUILD)
+typedef ESP8266WebServer halhttpserver_t;       // management, web and ascom servers
+#else
+typedef WebServer halhttpserver_t;
+#endif
+
+#endif
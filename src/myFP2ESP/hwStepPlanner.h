@@ -0,0 +1,122 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP HARDWARE STEP GENERATOR SEGMENT PLANNER
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+// Used with HWSTEPGEN on ESP32 DRV8825 boards. LEDC generates the STEP pulses and PCNT counts them.
+// PCNT is an int16 counter, so a move is split into segments of segsteps pulses. The counter resets
+// to 0 when it reaches the high limit (segsteps), and the threshold event catches the remainder of
+// the last segment. LEDC is stopped one pulse before the end of the move and the last pulse is made
+// with LEDC stopped, so a late interrupt cannot let LEDC step past the target. This class only does
+// the bookkeeping, it has no hardware or Arduino dependencies so it can be compiled and checked on a PC.
+
+#ifndef hwStepPlanner_h
+#define hwStepPlanner_h
+
+#include <stdint.h>
+
+#define HWPLANNER_INLINE inline __attribute__((always_inline))
+
+class HWStepPlanner
+{
+  public:
+    // start a move of steps pulses, PCNT high limit is segsteps
+    HWPLANNER_INLINE void begin(uint32_t steps, uint32_t segsteps)
+    {
+      this->total = steps;
+      this->segsteps = segsteps;
+      this->base = 0;
+      this->sdelay0 = 0;
+      this->table = 0;
+      this->inc = 0;
+    }
+
+    // ramp to use, values as set by DriverBoard::initramp(), inc of 0 runs the whole move at startdelay
+    HWPLANNER_INLINE void setramp(const uint16_t* rtable, uint32_t startdelay, uint32_t first, uint32_t top, uint32_t rinc)
+    {
+      this->table = rtable;
+      this->sdelay0 = startdelay;
+      this->first = first;
+      this->top = top;
+      this->inc = rinc;
+    }
+
+    // steps in the move
+    HWPLANNER_INLINE uint32_t steps(void)
+    {
+      return this->total;
+    }
+
+    // pulses LEDC makes before it is stopped, a move of 1 step is made without LEDC
+    HWPLANNER_INLINE uint32_t ledcsteps(void)
+    {
+      return ( this->total > 0 ) ? this->total - 1 : 0;
+    }
+
+    // threshold for the last segment, 0 when LEDC stops on a segment boundary and the high limit event stops it
+    HWPLANNER_INLINE uint32_t remainder(void)
+    {
+      return ledcsteps() % this->segsteps;
+    }
+
+    // PCNT reached the high limit and reset to 0, returns true if LEDC must stop
+    HWPLANNER_INLINE bool onlimit(void)
+    {
+      this->base += this->segsteps;
+      return this->base >= ledcsteps();
+    }
+
+    // PCNT reached remainder(), this happens once in every segment, returns true only in the last one
+    HWPLANNER_INLINE bool onthreshold(void)
+    {
+      return (this->base + this->remainder()) >= ledcsteps();
+    }
+
+    // steps taken, count is the current PCNT value
+    HWPLANNER_INLINE uint32_t stepsdone(uint32_t count)
+    {
+      return this->base + count;
+    }
+
+    // steps taken once LEDC is stopped, count is the current PCNT value. Pulses after the event that
+    // stopped LEDC are counted from the count at that event, the counter may have wrapped at segsteps
+    // since without onlimit() being called
+    HWPLANNER_INLINE uint32_t stepsafterstop(uint32_t count)
+    {
+      uint32_t stopcount = ledcsteps() - this->base;
+      return ledcsteps() + ((count + this->segsteps - stopcount) % this->segsteps);
+    }
+
+    // step interval in uS when count steps into the current segment, ramps up over the first steps
+    // and down over the last steps, the same profile the timer ISR follows when stepping in software
+    HWPLANNER_INLINE uint32_t sdelay(uint32_t count)
+    {
+      if ( this->inc == 0 )
+      {
+        return this->sdelay0;
+      }
+      uint32_t done = stepsdone(count);
+      done = ( done > this->total ) ? this->total : done;
+      uint32_t n = ( done < (this->total - done) ) ? done : (this->total - done);
+      uint32_t idx = ( n >= ((this->top - this->first) / this->inc) ) ? this->top : (this->first + this->inc * n);
+      return this->table[idx >> RAMPFRACBITS];
+    }
+
+  private:
+    uint32_t total;                     // steps in the move
+    uint32_t segsteps;                  // PCNT high limit
+    uint32_t base;                      // steps in completed segments
+    uint32_t sdelay0;                   // start step interval in uS
+    const uint16_t* table;              // ramp table, see rampTable.h
+    uint32_t first;                     // ramp index of the start speed, RAMPFRACBITS fraction bits
+    uint32_t top;                       // ramp index of the top speed
+    uint32_t inc;                       // ramp index increment per step
+};
+
+#endif
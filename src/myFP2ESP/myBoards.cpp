@@ -12,6 +12,8 @@
 #include <Arduino.h>
 #include "generalDefinitions.h"
 #include "myBoards.h"
+#include "rampTable.h"
+#include "stepTimer.h"
 
 // ____ESP8266 Boards
 #if DRVBRD == WEMOSDRV8825H
@@ -53,29 +55,62 @@ const char* DRVBRD_ID = "UNKNOWN";
 
 volatile bool timerSemaphore = false;
 volatile uint32_t stepcount = 0;
+volatile uint32_t backlashcount = 0;                          // backlash steps to take before stepcount
+volatile bool stepjob = false;                                // motor job is running or not
 bool stepdir;
 byte reverse_dir;
 extern DriverBoard* driverboard;
 extern bool HPS_alert(void);
+#ifdef TIMEMOVESTART
+volatile uint32_t movecmdtime = 0;
+volatile uint32_t firststeptime = 0;
+#endif
+
+// acceleration ramp tables, generated at compile time and held in flash, one for each stepmode the board supports
+#if (DRVBRD == PRO2ESP32DRV8825 )
+const ramptable_t ramp_step1 PROGMEM = ramptable(STEP1);
+const ramptable_t ramp_step2 PROGMEM = ramptable(STEP2);
+const ramptable_t ramp_step4 PROGMEM = ramptable(STEP4);
+const ramptable_t ramp_step8 PROGMEM = ramptable(STEP8);
+const ramptable_t ramp_step16 PROGMEM = ramptable(STEP16);
+const ramptable_t ramp_step32 PROGMEM = ramptable(STEP32);
+static_assert(ramptableok(STEP1) && ramptableok(STEP2) && ramptableok(STEP4)
+              && ramptableok(STEP8) && ramptableok(STEP16) && ramptableok(STEP32), "ramp table does not match profile");
+#elif (DRVBRD == WEMOSDRV8825 || DRVBRD == PRO2EDRV8825 || DRVBRD == PRO2ESP32R3WEMOS || DRVBRD == WEMOSDRV8825H)
+const ramptable_t ramp_fixed PROGMEM = ramptable(DRV8825TEPMODE);
+static_assert(ramptableok(DRV8825TEPMODE), "ramp table does not match profile");
+#elif (DRVBRD == PRO2EL293DNEMA || DRVBRD == PRO2EL293D28BYJ48 )
+const ramptable_t ramp_step1 PROGMEM = ramptable(STEP1);
+static_assert(ramptableok(STEP1), "ramp table does not match profile");
+#else
+const ramptable_t ramp_step1 PROGMEM = ramptable(STEP1);
+const ramptable_t ramp_step2 PROGMEM = ramptable(STEP2);
+static_assert(ramptableok(STEP1) && ramptableok(STEP2), "ramp table does not match profile");
+#endif
+
+// the ISR cannot read flash while SPIFFS is writing, so the table for the current stepmode is copied to RAM
+// the ramp is walked by nextstepdelay() in stepTimer.h
+static_assert(((uint64_t) RAMPTABLESIZE << RAMPFRACBITS) <= 0x80000000ULL, "ramp index does not fit in 32 bits");
+uint16_t activeramp[RAMPTABLESIZE];
+uint32_t activerampaccel = 1;
+volatile uint32_t rampinc = 0;
+volatile uint32_t rampidx = 0;
+volatile uint32_t rampfirst = 0;
+volatile uint32_t ramptop = 0;
+volatile uint32_t rampsteps = 0;
 
 // timer Interrupt
+// the timer is set up once in the DriverBoard constructor, initmove() arms it and it is disarmed when
+// the move completes or on halt()
 #if defined(ESP8266)
-#include "ESP8266TimerInterrupt.h"
-ESP8266Timer myfp2Timer;                                      // use a unique name for the timer
+// timer1 is driven directly so the ISR can reload the period on every step
+// TIM_DIV16 gives 5 ticks per uS, max interval 1.6s
+#define TIMER1TICKSPERUS  5
 #else
 #include "esp32-hal-cpu.h"                                    // so we can get CPU frequency
 hw_timer_t * myfp2timer = NULL;                               // use a unique name for the timer
 #endif
 
-/*
-  stepcount   HPS_altert    stepdir           action
-  ----------------------------------------------------
-    0           x             x             stop
-    >0        false           x             step
-    !0        true        moving_in         stop
-    !0        true        moving_out        step
-*/
-
 inline void asm2uS()  __attribute__((always_inline));
 
 // On esp8266 with 80mHz clock a nop takes 1/80000000 second, i.e. one clock pulse, or 0.0000000125 of a second
@@ -83,8 +118,7 @@ inline void asm2uS()  __attribute__((always_inline));
 // To get to 2uS for ESP8266 we will need 80 nop instructions
 // On esp32 with 240mHz clock a nop takes ? 1/240000000 second or 0.000000004166 of a second
 // To get to 2us for ESP32 we will need 240 nop instructions
-// TODO
-// I need to finish code with clock_frequency and half asm1uS calls if using a clock frequency of 120MHZ on ESP32
+// DRV8825 boards now time the STEP pulse with the cycle counter, see waitcycles()
 
 inline void asm1uS()                  // 1uS on ESP8266, 1/3uS on ESP32
 {
@@ -133,62 +167,375 @@ inline void asm1uS()                  // 1uS on ESP8266, 1/3uS on ESP32
   );
 }
 
+// fast pin writes for movemotor(), which runs in the ISR. pin numbers are constants so the
+// ESP32 bank test is resolved by the compiler and each write is a single register store
+#if defined(ESP8266)
+#define PINHIGH(pin)  (GPOS = (1UL << (pin)))
+#define PINLOW(pin)   (GPOC = (1UL << (pin)))
+#else
+#include "soc/gpio_struct.h"
+#define PINHIGH(pin)  do { if ((pin) < 32) GPIO.out_w1ts = (1UL << (pin)); else GPIO.out1_w1ts.val = (1UL << ((pin) - 32)); } while (0)
+#define PINLOW(pin)   do { if ((pin) < 32) GPIO.out_w1tc = (1UL << (pin)); else GPIO.out1_w1tc.val = (1UL << ((pin) - 32)); } while (0)
+#endif
+#define PINWRITE(pin, val)  do { if (val) PINHIGH(pin); else PINLOW(pin); } while (0)
+
+#if (DRVBRD == WEMOSDRV8825 || DRVBRD == PRO2EDRV8825 || DRVBRD == WEMOSDRV8825H)
+static_assert((DIRPIN < 16) && (STEPPIN < 16) && (ENABLEPIN < 16), "GPOS/GPOC only handle GPIO0-15");
+#endif
+
+inline uint32_t cyclecount() __attribute__((always_inline));
+
+inline uint32_t cyclecount()           // CPU clock cycles, ESP8266 and ESP32 are both Xtensa
+{
+  uint32_t ccount;
+  asm volatile ("rsr %0, ccount" : "=a" (ccount));
+  return ccount;
+}
+
+inline void waitcycles(uint32_t) __attribute__((always_inline));
+
+inline void waitcycles(uint32_t cycles)
+{
+  uint32_t start = cyclecount();
+  while ( (cyclecount() - start) < cycles )
+  {
+    ;
+  }
+}
+
+// step timing probe. onTimer() is the only writer, getsteptiming() copies the counters and the ring
+// without stopping the ISR, steptiminghead is advanced last so a sample is complete once it is counted
+#ifdef STEPTIMING
+volatile uint32_t steplatehist[STEPTIMINGBINS];
+volatile uint32_t stepisrhist[STEPTIMINGBINS];
+volatile uint32_t steplatering[STEPTIMINGRING];
+volatile uint32_t stepisrring[STEPTIMINGRING];
+volatile uint32_t steplatemax = 0;
+volatile uint32_t stepisrmax = 0;
+volatile uint32_t steptiminghead = 0;                         // samples recorded, next ring slot is head & (STEPTIMINGRING - 1)
+volatile uint32_t steptimingbase = 0;                         // head at the last reset
+volatile uint32_t stepperiod = 0;                             // cycles the timer was armed for, 0 = do not measure next tick
+volatile uint32_t steplasttick = 0;                           // cycle count at the last tick or when the timer was armed
+uint32_t stepcyclesperus = 80;
+
+inline uint32_t steptimingbin(uint32_t) __attribute__((always_inline));
+
+inline uint32_t steptimingbin(uint32_t cycles)      // no __builtin_clz, it is not in IRAM on ESP8266
+{
+  uint32_t bin = 0;
+  while ( cycles && (bin < (STEPTIMINGBINS - 1)) )
+  {
+    cycles >>= 1;
+    bin++;
+  }
+  return bin;
+}
+
+// call on entry to onTimer() with the cycle count, returns the interval error of this tick
+inline uint32_t steptimingstart(uint32_t) __attribute__((always_inline));
+
+inline uint32_t steptimingstart(uint32_t now)
+{
+  uint32_t late = 0;
+  if ( stepperiod )
+  {
+    uint32_t interval = now - steplasttick;
+    late = ( interval > stepperiod ) ? (interval - stepperiod) : (stepperiod - interval);
+  }
+  steplasttick = now;
+  return late;
+}
+
+// call on exit from onTimer()
+inline void steptimingend(uint32_t, uint32_t) __attribute__((always_inline));
+
+inline void steptimingend(uint32_t start, uint32_t late)
+{
+  uint32_t isr = cyclecount() - start;
+  uint32_t slot = steptiminghead & (STEPTIMINGRING - 1);
+  steplatering[slot] = late;
+  stepisrring[slot] = isr;
+  steplatehist[steptimingbin(late)]++;
+  stepisrhist[steptimingbin(isr)]++;
+  if ( late > steplatemax )
+  {
+    steplatemax = late;
+  }
+  if ( isr > stepisrmax )
+  {
+    stepisrmax = isr;
+  }
+  steptiminghead++;
+}
+
+#define STEPTIMINGSTART()       uint32_t ststart = cyclecount(); uint32_t stlate = steptimingstart(ststart)
+#define STEPTIMINGEND()         steptimingend(ststart, stlate)
+#define STEPTIMINGPERIOD(us)    (stepperiod = (us) * stepcyclesperus)
+#define STEPTIMINGARM(us)       do { stepperiod = (us) * stepcyclesperus; steplasttick = cyclecount(); } while (0)
+#else
+#define STEPTIMINGSTART()
+#define STEPTIMINGEND()
+#define STEPTIMINGPERIOD(us)
+#define STEPTIMINGARM(us)
+#endif
+
+// hardware step generator, LEDC drives STEPPIN and PCNT counts the pulses, see hwStepPlanner.h
+// the CPU is interrupted once per segment of HWSEGMENTSTEPS, plus a HWTICKUS tick from myfp2timer to
+// follow the ramp and check the home position switch
+#if defined(HWSTEPGEN)
+#include "driver/pcnt.h"
+#include "soc/pcnt_struct.h"
+#include "soc/pcnt_reg.h"
+#include "soc/ledc_struct.h"
+#include "hwStepPlanner.h"
+
+HWStepPlanner hwplanner;
+volatile bool hwmoving = false;                               // LEDC is generating pulses
+volatile bool hwactive = false;                               // position is start +/- steps done
+volatile uint32_t hwdone = 0;                                 // steps taken when the move stopped
+unsigned long hwstartpos = 0;                                 // focuser position at start of move
+uint32_t hwbacklash = 0;                                      // backlash pulses at the start of the move
+uint32_t hwpulsecycles = 0;                                   // STEP pulse width in CPU cycles
+bool hwleds = false;
+
+#define HWCOUNT()     ((uint32_t) PCNT.cnt_unit[HWPCNTUNIT].cnt_val)
+#define HWCHANNEL     LEDC.channel_group[0].channel[HWLEDCCHANNEL]
+#define HWSTEPLEVEL() ((STEPPIN < 32) ? ((GPIO.in >> STEPPIN) & 1) : ((GPIO.in1.val >> (STEPPIN - 32)) & 1))
+
+// LEDC timer period is 2^HWLEDCBITS ticks of 80MHz / divider, divider is 10.8 fixed point
+inline void hwsetdelay(uint32_t) __attribute__((always_inline));
+
+inline void hwsetdelay(uint32_t sdelay)
+{
+  uint32_t div = (sdelay * 80UL * 256UL) >> HWLEDCBITS;
+  div = (div < 256) ? 256 : (div > 0x3FFFF) ? 0x3FFFF : div;
+  LEDC.timer_group[0].timer[HWLEDCTIMER].conf.clock_divider = div;
+}
+
+// start pulses from the beginning of a period, so the first step is immediate
+inline void hwstart(void) __attribute__((always_inline));
+
+inline void hwstart(void)
+{
+  LEDC.timer_group[0].timer[HWLEDCTIMER].conf.rst = 1;
+  LEDC.timer_group[0].timer[HWLEDCTIMER].conf.rst = 0;
+  HWCHANNEL.conf0.sig_out_en = 1;
+}
+
+// output goes to the idle level (low), PCNT counts falling edges so a pulse cut short is still counted
+inline void hwstop(void) __attribute__((always_inline));
+
+inline void hwstop(void)
+{
+  HWCHANNEL.conf0.sig_out_en = 0;
+}
+
+// one STEP pulse with LEDC stopped, STEPPIN is at the idle level so raising the idle level makes the pulse
+inline void hwpulse(void) __attribute__((always_inline));
+
+inline void hwpulse(void)
+{
+  HWCHANNEL.conf0.idle_lv = 1;          // Step pin on
+  waitcycles(hwpulsecycles);            // DRV8825 chip needs a 2uS pulse
+  HWCHANNEL.conf0.idle_lv = 0;          // Step pin off
+}
+
+// move complete, or stopped by the home position switch, done is the steps taken, called from ISR
+void IRAM_ATTR hwfinish(uint32_t done)
+{
+  hwstop();
+  hwdone = done;
+  hwmoving = false;
+  timerAlarmDisable(myfp2timer);
+#if (DRVBRD == PRO2ESP32DRV8825 )
+  if ( hwleds )
+  {
+    PINLOW(INLEDPIN);
+    PINLOW(OUTLEDPIN);
+  }
+#endif
+  timerSemaphore = true;
+}
+
+// LEDC reached ledcsteps(), stop it and make the last pulse of the move. The next LEDC pulse is half a
+// period away, if it has already started it is left to reach full width and is the last pulse
+void IRAM_ATTR hwlaststep(void)
+{
+  if ( HWSTEPLEVEL() )
+  {
+    waitcycles(hwpulsecycles);
+  }
+  hwstop();
+  uint32_t done = hwplanner.stepsafterstop(HWCOUNT());
+  if ( done < hwplanner.steps() )
+  {
+    hwpulse();
+    done++;
+  }
+  hwfinish(done);
+}
+
+// PCNT reached the high limit, or the threshold for the remainder of the last segment
+void IRAM_ATTR hwpcntisr(void *arg)
+{
+  uint32_t status = PCNT.status_unit[HWPCNTUNIT].val;
+  PCNT.int_clr.val = BIT(HWPCNTUNIT);
+  if ( hwmoving )
+  {
+    bool done = false;
+    if ( status & PCNT_STATUS_H_LIM_M )
+    {
+      done = hwplanner.onlimit();
+    }
+    if ( status & PCNT_STATUS_THRES0_M )
+    {
+      done = done || hwplanner.onthreshold();
+    }
+    if ( done )
+    {
+      hwlaststep();
+    }
+  }
+}
+#endif // #if defined(HWSTEPGEN)
+
+// homing, the home position switch interrupt stops the move on the edge wanted by the current phase
+volatile byte homephase = HOMEIDLE;
+volatile bool homeedge = false;
+
+#if (HPSWPIN != -1)
+#if defined(ESP8266)
+ICACHE_RAM_ATTR void hpswisr(void)
+#else
+void IRAM_ATTR hpswisr(void)
+#endif
+{
+  if ( homeswitchedge(!digitalRead(HPSWPIN)) )
+  {
+#if defined(HWSTEPGEN)
+    if ( hwmoving )
+    {
+      hwfinish(hwplanner.stepsdone(HWCOUNT()));
+    }
+#else
+    stepstop();                   // onTimer() ends the move on its next tick without another step
+#endif
+  }
+}
+#endif
+
 // timer ISR  Interrupt Service Routine
 #if defined(ESP8266)
 ICACHE_RAM_ATTR void onTimer()
 {
-  static bool mjob = false;      // motor job is running or not
-  if (stepcount  && !(HPS_alert() && stepdir == moving_in))
+  STEPTIMINGSTART();
+  byte action = steptick(HPS_alert());
+  if ( action == STEPTICKBACKLASH )
   {
-    driverboard->movemotor(stepdir, true);
-    stepcount--;
-    mjob = true;                  // mark a running job
+    driverboard->movemotor(stepdir, false);   // take up backlash first, position does not change
   }
-  else
+  else if ( action == STEPTICKSTEP )
   {
-    if (mjob == true)
+    driverboard->movemotor(stepdir, true);
+#ifdef TIMEMOVESTART
+    if ( firststeptime == 0 )
     {
-      stepcount = 0;              // just in case HPS_alert was fired up
-      mjob = false;               // wait, and do nothing
-      timerSemaphore = true;
+      firststeptime = micros();
     }
+#endif
+    if ( rampinc )
+    {
+      uint32_t sdelay = nextstepdelay();
+      timer1_write(sdelay * TIMER1TICKSPERUS);             // reload period for next step
+      STEPTIMINGPERIOD(sdelay);
+    }
+  }
+  else
+  {
+    timer1_disable();             // disarm, initmove() will arm it again
+    stepstopped();
   }
+  STEPTIMINGEND();
+}
+#elif defined(HWSTEPGEN)
+// LEDC makes the steps, the timer only follows the ramp and checks the home position switch
+void IRAM_ATTR onTimer()
+{
+  STEPTIMINGSTART();
+  if ( !hwmoving )
+  {
+    timerAlarmDisable(myfp2timer);
+  }
+  else if ( HPS_alert() && stepdir == moving_in )
+  {
+    hwfinish(hwplanner.stepsdone(HWCOUNT()));
+  }
+  else if ( rampinc )
+  {
+    hwsetdelay(hwplanner.sdelay(HWCOUNT()));
+  }
+  STEPTIMINGEND();
 }
 #else
 void IRAM_ATTR onTimer()
 {
-  static bool mjob = false;      // motor job is running or not
-  if (stepcount  && !(HPS_alert() && stepdir == moving_in))
+  STEPTIMINGSTART();
+  byte action = steptick(HPS_alert());
+  if ( action == STEPTICKBACKLASH )
   {
-    driverboard->movemotor(stepdir, true);
-    stepcount--;
-    mjob = true;                  // mark a running job
+    driverboard->movemotor(stepdir, false);   // take up backlash first, position does not change
   }
-  else
+  else if ( action == STEPTICKSTEP )
   {
-    if (mjob == true)
+    driverboard->movemotor(stepdir, true);
+#ifdef TIMEMOVESTART
+    if ( firststeptime == 0 )
     {
-      stepcount = 0;              // just in case HPS_alert was fired up
-      mjob = false;               // wait, and do nothing
-      timerSemaphore = true;
+      firststeptime = micros();
     }
+#endif
+    if ( rampinc )
+    {
+      uint32_t sdelay = nextstepdelay();
+      timerAlarmWrite(myfp2timer, sdelay, true);           // reload period for next step
+      STEPTIMINGPERIOD(sdelay);
+    }
+  }
+  else
+  {
+    timerAlarmDisable(myfp2timer);  // disarm, initmove() will arm it again
+    stepstopped();
   }
+  STEPTIMINGEND();
 }
 #endif
 
 DriverBoard::DriverBoard(byte brdtype, unsigned long startposition) : boardtype(brdtype)
 {
   do {
-#if defined(ESP8266)
-    // do nothing
-#else
-    // esp32
     clock_frequency = ESP.getCpuFreqMHz();    // returns the CPU frequency in MHz as an unsigned 8-bit integer
     //Serial.print("Clock Freq: ");
     //Serial.println(clock_frequency);
+    this->pulsecycles = MOTORPULSETIME * clock_frequency;   // DRV8825 needs 2uS STEP pulse and DIR setup
+#ifdef STEPTIMING
+    stepcyclesperus = clock_frequency;
+#endif
+    this->lastdir = 0xff;
+
+#if defined(ESP8266)
+    timer1_disable();
+    timer1_attachInterrupt(onTimer);          // timer stays disarmed until initmove()
+#else
+    // Use 1st timer of 4 (counted from zero).
+    // Set 80 divider for prescaler (see ESP32 Technical Reference Manual), 1 tick per uS
+    myfp2timer = timerBegin(0, 80, true);
+    timerAttachInterrupt(myfp2timer, &onTimer, true);  // Attach onTimer function to our timer.
+    timerAlarmDisable(myfp2timer);            // timer stays disarmed until initmove()
 #endif
 
     this->stepdelay = MSPEED;
+    this->accel = 0;                          // no ramp until set from mySetupData
+    this->maxspeeddelay = MSPEED;
 
 #if (DRVBRD == WEMOSDRV8825 || DRVBRD == PRO2EDRV8825 || DRVBRD == PRO2ESP32R3WEMOS || DRVBRD == WEMOSDRV8825H )
     pinMode(ENABLEPIN, OUTPUT);
@@ -281,6 +628,33 @@ DriverBoard::DriverBoard(byte brdtype, unsigned long startposition) : boardtype(
     mystepper = new Stepper(STEPSPERREVOLUTION, IN2, IN3, IN1, IN4);  // DONE
     setstepmode(STEP1);
 #endif
+
+#if defined(HWSTEPGEN)
+    // PCNT counts falling edges on STEPPIN, ie completed pulses, and resets at HWSEGMENTSTEPS
+    pcnt_config_t pcntconfig = { };
+    pcntconfig.pulse_gpio_num = STEPPIN;
+    pcntconfig.ctrl_gpio_num = PCNT_PIN_NOT_USED;
+    pcntconfig.channel = PCNT_CHANNEL_0;
+    pcntconfig.unit = (pcnt_unit_t) HWPCNTUNIT;
+    pcntconfig.pos_mode = PCNT_COUNT_DIS;
+    pcntconfig.neg_mode = PCNT_COUNT_INC;
+    pcntconfig.lctrl_mode = PCNT_MODE_KEEP;
+    pcntconfig.hctrl_mode = PCNT_MODE_KEEP;
+    pcntconfig.counter_h_lim = HWSEGMENTSTEPS;
+    pcntconfig.counter_l_lim = -1;
+    pcnt_unit_config(&pcntconfig);
+    pcnt_filter_disable((pcnt_unit_t) HWPCNTUNIT);
+    pcnt_event_enable((pcnt_unit_t) HWPCNTUNIT, PCNT_EVT_H_LIM);
+    pcnt_isr_register(hwpcntisr, NULL, 0, NULL);
+    pcnt_intr_enable((pcnt_unit_t) HWPCNTUNIT);
+
+    // LEDC drives STEPPIN with a 50% duty square wave, the pad input stays enabled so PCNT can read it back
+    ledcSetup(HWLEDCCHANNEL, 1000, HWLEDCBITS);
+    ledcAttachPin(STEPPIN, HWLEDCCHANNEL);
+    ledcWrite(HWLEDCCHANNEL, 1 << (HWLEDCBITS - 1));
+    hwstop();
+    PIN_INPUT_ENABLE(GPIO_PIN_MUX_REG[STEPPIN]);
+#endif
     // set default focuser position - ensure it is same as mySetupData when loaded
     this->focuserposition = startposition;
   } while (0);
@@ -289,6 +663,14 @@ DriverBoard::DriverBoard(byte brdtype, unsigned long startposition) : boardtype(
 // destructor
 DriverBoard::~DriverBoard()
 {
+#if defined(ESP8266)
+  timer1_disable();
+  timer1_detachInterrupt();
+#else
+  timerAlarmDisable(myfp2timer);
+  timerDetachInterrupt(myfp2timer);
+  timerEnd(myfp2timer);
+#endif
 #if ( DRVBRD == PRO2EULN2003   || DRVBRD == PRO2ESP32ULN2003  \
    || DRVBRD == PRO2EL298N     || DRVBRD == PRO2ESP32L298N    \
    || DRVBRD == PRO2EL293DMINI || DRVBRD == PRO2ESP32L293MINI \
@@ -378,6 +760,7 @@ void DriverBoard::setstepmode(int smode)
 
 #endif
   } while (0);
+  DriverBoard::loadramp();
 }
 
 void DriverBoard::enablemotor(void)
@@ -413,46 +796,30 @@ void DriverBoard::movemotor(byte dir, bool updatefpos)
 #if (DRVBRD == PRO2ESP32ULN2003 || DRVBRD == PRO2ESP32L298N || DRVBRD == PRO2ESP32L293DMINI || DRVBRD == PRO2ESP32L9110S) || (DRVBRD == PRO2ESP32DRV8825 )
   if ( drvbrdleds )
   {
-    ( dir == moving_in ) ? digitalWrite(INLEDPIN, 1) : digitalWrite(OUTLEDPIN, 1);
+    if ( dir == moving_in )
+    {
+      PINHIGH(INLEDPIN);
+    }
+    else
+    {
+      PINHIGH(OUTLEDPIN);
+    }
   }
 #endif
 
 #if (DRVBRD == WEMOSDRV8825 || DRVBRD == PRO2EDRV8825 || DRVBRD == PRO2ESP32DRV8825 || DRVBRD == PRO2ESP32R3WEMOS || DRVBRD == WEMOSDRV8825H)
-  if ( reverse_dir == 1 )
+  byte pindir = ( reverse_dir == 1 ) ? !dir : dir;
+  PINWRITE(DIRPIN, pindir);             // set Direction of travel
+  PINLOW(ENABLEPIN);                    // Enable Motor Driver
+  if ( pindir != this->lastdir )
   {
-    digitalWrite(DIRPIN, !dir);         // set Direction of travel
+    this->lastdir = pindir;
+    waitcycles(this->pulsecycles);      // DIR must be stable before STEP goes high
   }
-  else
-  {
-    digitalWrite(DIRPIN, dir);          // set Direction of travel
-  }
-  digitalWrite(ENABLEPIN, 0);           // Enable Motor Driver
-  digitalWrite(STEPPIN, 1);             // Step pin on
-#if defined(ESP8266)
-  asm1uS();                             // ESP8266 must be 2uS delay for DRV8825 chip
-  asm1uS();
-  asm1uS();
-#else
-  // ESP32
-  if ( clock_frequency == 160 )
-  {
-    asm1uS();                           // ESP32 must be 2uS delay for DRV8825 chip
-    asm1uS();
-    asm1uS();
-    asm1uS();
-  }
-  else
-  {
-    // assume clock frequency is 240mHz
-    asm1uS();                             // ESP32 must be 2uS delay for DRV8825 chip
-    asm1uS();
-    asm1uS();
-    asm1uS();
-    asm1uS();
-    asm1uS();
-  }
-#endif // #if defined(ESP8266)
-  digitalWrite(STEPPIN, 0);               // Step pin off
+  // not used when HWSTEPGEN is defined, LEDC makes the steps of every move including backlash
+  PINHIGH(STEPPIN);                     // Step pin on
+  waitcycles(this->pulsecycles);        // DRV8825 chip needs a 2uS pulse
+  PINLOW(STEPPIN);                      // Step pin off
 #endif // #if (DRVBRD == WEMOSDRV8825 || DRVBRD == PRO2EDRV8825 || DRVBRD == PRO2ESP32DRV8825 || DRVBRD == PRO2ESP32R3WEMOS || DRVBRD == WEMOSDRV8825H)
 
 #if (DRVBRD == PRO2EULN2003     || DRVBRD == PRO2ESP32ULN2003  \
@@ -490,7 +857,14 @@ void DriverBoard::movemotor(byte dir, bool updatefpos)
 #if (DRVBRD == PRO2ESP32ULN2003 || DRVBRD == PRO2ESP32L298N || DRVBRD == PRO2ESP32L293DMINI || DRVBRD == PRO2ESP32L9110S) || (DRVBRD == PRO2ESP32DRV8825 )
   if ( drvbrdleds )
   {
-    ( dir == moving_in ) ? digitalWrite(INLEDPIN, 0) : digitalWrite(OUTLEDPIN, 0);
+    if ( dir == moving_in )
+    {
+      PINLOW(INLEDPIN);
+    }
+    else
+    {
+      PINLOW(OUTLEDPIN);
+    }
   }
 #endif
   // update focuser position
@@ -502,20 +876,28 @@ void DriverBoard::movemotor(byte dir, bool updatefpos)
 
 void DriverBoard::halt(void)
 {
+  // disarm only, the timer and interrupt stay set up for the next move
 #if defined(ESP8266)
-  myfp2Timer.detachInterrupt();
+  timer1_disable();
 #else
   timerAlarmDisable(myfp2timer);      // stop alarm
-  timerDetachInterrupt(myfp2timer);   // detach interrupt
-  timerEnd(myfp2timer);               // end timer
+#endif
+#if defined(HWSTEPGEN)
+  if ( hwmoving )
+  {
+    hwstop();                         // stop pulses first, then the count is exact
+    hwdone = hwplanner.stepsdone(HWCOUNT());
+    hwmoving = false;
+  }
 #endif
   DebugPrint(F(">halt_alert "));
-  delay(10);
 }
 
-void DriverBoard::initmove(bool dir, unsigned long steps, byte motorspeed, bool leds, byte reversedir)
+// backlash steps are taken at the start of the move and do not change the focuser position
+void DriverBoard::initmove(bool dir, unsigned long steps, byte motorspeed, bool leds, byte reversedir, unsigned long backlash)
 {
   stepcount = steps;
+  backlashcount = backlash;
   stepdir = dir;
   reverse_dir = reversedir;
   DriverBoard::enablemotor();
@@ -526,6 +908,8 @@ void DriverBoard::initmove(bool dir, unsigned long steps, byte motorspeed, bool
   DebugPrint(dir);
   DebugPrint(F(":"));
   DebugPrint(steps);
+  DebugPrint(F(":"));
+  DebugPrint(backlash);
   DebugPrint(F(" "));
 
   //Serial.print("initmove: ");
@@ -536,7 +920,6 @@ void DriverBoard::initmove(bool dir, unsigned long steps, byte motorspeed, bool
   //Serial.print(motorspeed);
   //Serial.print(" : ");
   //Serial.println(leds);
-#if defined(ESP8266)
   unsigned long curspd = DriverBoard::getstepdelay();
   switch ( motorspeed )
   {
@@ -547,31 +930,151 @@ void DriverBoard::initmove(bool dir, unsigned long steps, byte motorspeed, bool
       curspd *= 2;
       break;
   }
-  if (myfp2Timer.attachInterruptInterval(curspd, onTimer) == false)
+  // curspd is the start speed, ramp up from there if acceleration is enabled
+  curspd = DriverBoard::initramp(curspd);
+
+#if defined(HWSTEPGEN)
+  // position is worked out from the PCNT count until the next setposition() or initmove()
+  this->focuserposition = DriverBoard::getposition();
+  hwstartpos = this->focuserposition;
+  hwbacklash = backlash;
+  hwplanner.begin(steps + backlash, HWSEGMENTSTEPS);
+  hwplanner.setramp(activeramp, curspd, rampfirst, ramptop, rampinc);
+
+  byte pindir = ( reverse_dir == 1 ) ? !dir : dir;
+  PINWRITE(DIRPIN, pindir);
+  PINLOW(ENABLEPIN);
+  if ( pindir != this->lastdir )
   {
-    DebugPrint(F("Can't set myfp2Timer correctly. Select another freq. or interval"));
+    this->lastdir = pindir;
+    waitcycles(this->pulsecycles);      // DIR must be stable before STEP goes high
   }
+  hwleds = leds;
+  hwpulsecycles = this->pulsecycles;
+#if (DRVBRD == PRO2ESP32DRV8825 )
+  if ( hwleds )
+  {
+    if ( dir == moving_in )
+    {
+      PINHIGH(INLEDPIN);
+    }
+    else
+    {
+      PINHIGH(OUTLEDPIN);
+    }
+  }
+#endif
+
+  // threshold and limit values only take effect after the counter is cleared
+  pcnt_counter_pause((pcnt_unit_t) HWPCNTUNIT);
+  if ( hwplanner.remainder() )
+  {
+    pcnt_set_event_value((pcnt_unit_t) HWPCNTUNIT, PCNT_EVT_THRES_0, hwplanner.remainder());
+    pcnt_event_enable((pcnt_unit_t) HWPCNTUNIT, PCNT_EVT_THRES_0);
+  }
+  else
+  {
+    pcnt_event_disable((pcnt_unit_t) HWPCNTUNIT, PCNT_EVT_THRES_0);
+  }
+  pcnt_counter_clear((pcnt_unit_t) HWPCNTUNIT);
+  pcnt_counter_resume((pcnt_unit_t) HWPCNTUNIT);
+
+  hwdone = 0;
+  hwactive = true;
+  if ( (steps + backlash) == 0 )
+  {
+    timerSemaphore = true;
+    return;
+  }
+  if ( hwplanner.ledcsteps() == 0 )
+  {
+    hwpulse();                          // a single step is the last pulse, LEDC is not started
+    hwfinish(1);
+    return;
+  }
+  hwsetdelay(hwplanner.sdelay(0));
+  hwmoving = true;
+  hwstart();
+
+  // myfp2timer now only ticks to follow the ramp and check the home position switch
+  timerWrite(myfp2timer, 0);
+  timerAlarmWrite(myfp2timer, HWTICKUS, true);
+  STEPTIMINGARM(HWTICKUS);
+  timerAlarmEnable(myfp2timer);
+  return;
+#endif
+
+  // arm the timer set up in the constructor, first step is curspd uS from now
+#if defined(ESP8266)
+  timer1_enable(TIM_DIV16, TIM_EDGE, TIM_LOOP);
+  STEPTIMINGARM(curspd);
+  timer1_write(curspd * TIMER1TICKSPERUS);
 #else
-  // Use 1st timer of 4 (counted from zero).
-  // Set 80 divider for prescaler (see ESP32 Technical Reference Manual)
-  myfp2timer = timerBegin(0, 80, true);
-  timerAttachInterrupt(myfp2timer, &onTimer, true);  // Attach onTimer function to our timer.
+  timerWrite(myfp2timer, 0);                   // restart count from 0
+  timerAlarmWrite(myfp2timer, curspd, true);   // timer for ISR, repeat the alarm (third parameter)
+  STEPTIMINGARM(curspd);
+  timerAlarmEnable(myfp2timer);                // start timer alarm
+#endif
+}
 
-  // Set alarm to call onTimer function every second (value in microseconds).
-  // Repeat the alarm (third parameter)
-  unsigned long curspd = DriverBoard::getstepdelay();
-  switch ( motorspeed )
+// set up the ramp for a move starting at startdelay uS, returns the interval before the first step
+// the ISR then only adds rampinc to rampidx and reads activeramp
+unsigned long DriverBoard::initramp(unsigned long startdelay)
+{
+  if ( (this->accel <= 0) || !rampstart(this->accel, startdelay, this->maxspeeddelay) )
   {
-    case 0: // slow, 1/3rd the speed
-      curspd *= 3;
+    return startdelay;                          // no ramp, run whole move at startdelay
+  }
+  DebugPrint(F("ramp "));
+  DebugPrint(rampfirst >> RAMPFRACBITS);
+  DebugPrint(F(":"));
+  DebugPrint(ramptop >> RAMPFRACBITS);
+  DebugPrint(F(":"));
+  DebugPrintln(rampinc);
+  return startdelay;
+}
+
+// copy the flash table for the current stepmode to RAM for the ISR
+void DriverBoard::loadramp(void)
+{
+  const ramptable_t* table;
+  int smode;
+#if (DRVBRD == PRO2ESP32DRV8825 )
+  smode = this->stepmode;
+  switch ( smode )
+  {
+    case STEP2:
+      table = &ramp_step2;
       break;
-    case 1: // med, 1/2 the speed
-      curspd *= 2;
+    case STEP4:
+      table = &ramp_step4;
+      break;
+    case STEP8:
+      table = &ramp_step8;
+      break;
+    case STEP16:
+      table = &ramp_step16;
+      break;
+    case STEP32:
+      table = &ramp_step32;
+      break;
+    default:
+      table = &ramp_step1;
+      smode = STEP1;
       break;
   }
-  timerAlarmWrite(myfp2timer, curspd, true);   // timer for ISR
-  timerAlarmEnable(myfp2timer);                // start timer alarm
+#elif (DRVBRD == WEMOSDRV8825 || DRVBRD == PRO2EDRV8825 || DRVBRD == PRO2ESP32R3WEMOS || DRVBRD == WEMOSDRV8825H)
+  table = &ramp_fixed;
+  smode = DRV8825TEPMODE;
+#elif (DRVBRD == PRO2EL293DNEMA || DRVBRD == PRO2EL293D28BYJ48 )
+  table = &ramp_step1;
+  smode = STEP1;
+#else
+  smode = (this->stepmode == STEP2) ? STEP2 : STEP1;
+  table = (smode == STEP2) ? &ramp_step2 : &ramp_step1;
 #endif
+  memcpy_P(activeramp, table, sizeof(activeramp));
+  activerampaccel = rampaccel(smode);
 }
 
 int DriverBoard::getstepdelay(void)
@@ -584,12 +1087,112 @@ void DriverBoard::setstepdelay(int sdelay)
   this->stepdelay = sdelay;
 }
 
+int DriverBoard::getaccel(void)
+{
+  return this->accel;
+}
+
+void DriverBoard::setaccel(int newaccel)
+{
+  this->accel = (newaccel < 0) ? 0 : newaccel;
+}
+
+int DriverBoard::getmaxspeeddelay(void)
+{
+  return this->maxspeeddelay;
+}
+
+void DriverBoard::setmaxspeeddelay(int newdelay)
+{
+  this->maxspeeddelay = (newdelay < MINSTEPDELAY) ? MINSTEPDELAY : newdelay;
+}
+
+// call after pinMode(HPSWPIN, INPUT_PULLUP)
+void DriverBoard::inithomeswitch(void)
+{
+#if (HPSWPIN != -1)
+  attachInterrupt(digitalPinToInterrupt(HPSWPIN), hpswisr, CHANGE);
+#endif
+}
+
+// set before initmove() of a homing phase, HOMEIDLE for normal moves
+void DriverBoard::sethomephase(byte phase)
+{
+  homeedge = false;
+  homephase = phase;
+}
+
+// true if the last homing phase stopped on the home position switch edge
+bool DriverBoard::gethomeedge(void)
+{
+  return homeedge;
+}
+
+#ifdef STEPTIMING
+// copy the probe counters, samples the ISR overwrites in the ring while copying are dropped
+void DriverBoard::getsteptiming(steptiming_t* st)
+{
+  uint32_t head = steptiminghead;
+  st->samples = head - steptimingbase;
+  st->mhz = stepcyclesperus;
+  st->latemax = steplatemax;
+  st->isrmax = stepisrmax;
+  for ( int i = 0; i < STEPTIMINGBINS; i++ )
+  {
+    st->late[i] = steplatehist[i];
+    st->isr[i] = stepisrhist[i];
+  }
+  uint32_t n = ( st->samples < STEPTIMINGRING ) ? st->samples : STEPTIMINGRING;
+  for ( uint32_t i = 0; i < n; i++ )
+  {
+    uint32_t slot = (head - n + i) & (STEPTIMINGRING - 1);
+    st->recentlate[i] = steplatering[slot];
+    st->recentisr[i] = stepisrring[slot];
+  }
+  uint32_t overwritten = steptiminghead - head;
+  overwritten = ( overwritten < n ) ? overwritten : n;
+  st->recent = n - overwritten;
+  for ( uint32_t i = 0; i < st->recent; i++ )
+  {
+    st->recentlate[i] = st->recentlate[i + overwritten];
+    st->recentisr[i] = st->recentisr[i + overwritten];
+  }
+}
+
+void DriverBoard::resetsteptiming(void)
+{
+  for ( int i = 0; i < STEPTIMINGBINS; i++ )
+  {
+    steplatehist[i] = 0;
+    stepisrhist[i] = 0;
+  }
+  steplatemax = 0;
+  stepisrmax = 0;
+  steptimingbase = steptiminghead;
+}
+#endif
+
 unsigned long DriverBoard::getposition(void)
 {
+#if defined(HWSTEPGEN)
+  if ( hwactive )
+  {
+    uint32_t done = hwmoving ? hwplanner.stepsdone(HWCOUNT()) : hwdone;
+    done = ( done > hwbacklash ) ? (done - hwbacklash) : 0;
+    if ( stepdir == moving_in )
+    {
+      return ( done > hwstartpos ) ? 0 : hwstartpos - done;
+    }
+    return hwstartpos + done;
+  }
+#endif
   return this->focuserposition;
 }
 
 void DriverBoard::setposition(unsigned long pos)
 {
+#if defined(HWSTEPGEN)
+  hwactive = false;
+#endif
   this->focuserposition = pos;
 }
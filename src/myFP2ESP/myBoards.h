@@ -19,6 +19,9 @@
 // 1: BOARD DEFINES -- DO NOT CHANGE
 // ---------------------------------------------------------------------------
 // Uncomment only your board - ONLY ONE BOARD SHOULD BE UNCOMMENTED
+// A board given on the compiler command line (as the host build does) is used instead
+
+#ifndef DRVBRD
 
 // ESP8266 Boards
 #define DRVBRD WEMOSDRV8825H                    // driver definition for Holger
@@ -37,10 +40,15 @@
 //#define DRVBRD PRO2ESP32L293DMINI
 //#define DRVBRD PRO2ESP32L9110S
 //#define DRVBRD PRO2ESP32R3WEMOS
+#endif
 
 // THIS MUST MATCH THE STEPMODE SET IN HARDWARE JUMPERS ON THE PCB ESP8266-DRV
 #define DRV8825TEPMODE    STEP1         // jumpers MS1/2/3 on the PCB for ESP8266
 
+// PRO2ESP32DRV8825 and PRO2ESP32R3WEMOS only. To generate the STEP pulses with the LEDC peripheral
+// and count them with PCNT, instead of one timer interrupt per step, uncomment the next line
+//#define HWSTEPGEN 1
+
 // stepper motor steps per full revolution using full steps
 // WARNING: USE THE CORRECT ONE - IF YOU THEN CHANGE STEPMODE THE STEPS MOVED WILL BE INVALID
 #define STEPSPERREVOLUTION 2048        // 28BYJ-48 stepper motor unipolar with ULN2003 board
@@ -57,6 +65,27 @@
 #define SPEEDBIPOLAR      48            // RPM speed of 28BYJ48 is max of 48 rpm
 #define SPEEDNEMA         100           // RPM speed for NEMA motor
 
+// acceleration ramp, used when motoraccel in mySetupData is not 0, tables are generated in rampTable.h
+#define RAMPTABLESIZE     512           // entries in the ramp table for each stepmode, top speed is sqrt(512) x start speed
+#define RAMPSTARTRPM      3             // speed of the first entry in the ramp table
+#define RAMPFRACBITS      20            // fraction bits of the ramp table index, enough for small accelerations at STEP32
+#define MINSTEPDELAY      100           // shortest step interval in uS the ramp will accelerate to
+
+// hardware step generator, used when HWSTEPGEN is defined, see hwStepPlanner.h
+#define HWSEGMENTSTEPS    16000         // PCNT high limit, must be less than 32768
+#define HWLEDCCHANNEL     2             // LEDC high speed channel driving STEPPIN
+#define HWLEDCTIMER       1             // LEDC high speed timer of HWLEDCCHANNEL (channel / 2)
+#define HWLEDCBITS        11            // LEDC resolution, gives a step interval range of 25.6uS to 26214uS
+#define HWPCNTUNIT        0             // PCNT unit counting STEPPIN
+#define HWTICKUS          1000          // interval in uS to update the ramp and check the home position switch
+
+// step timing probe, onTimer() records how far each tick is from the period the timer was armed with
+// and how long the ISR runs, in CPU cycles. Read with /get?steptiming or :84#. It adds work to every
+// step, so it is off in a release build, to measure the step timing uncomment the next line
+//#define STEPTIMING        1
+#define STEPTIMINGBINS    24            // log2 histogram, bin n counts values from 2^(n-1) to 2^n - 1 cycles
+#define STEPTIMINGRING    32            // most recent samples kept, must be a power of 2
+
 // ---------------------------------------------------------------------------
 // DEFINITIONS FOR BOARDS: DO NOT CHANGE
 // ---------------------------------------------------------------------------
@@ -260,34 +289,76 @@
 #define MSPEED        8000
 #endif
 
+// homing phases, see DriverBoard::sethomephase()
+#define HOMEIDLE          0
+#define HOMEBACKOFF       1             // moving out, stop when the home position switch opens
+#define HOMEAPPROACH      2             // moving in slowly, stop when the home position switch closes
+
+#if defined(HWSTEPGEN) && !(DRVBRD == PRO2ESP32DRV8825 || DRVBRD == PRO2ESP32R3WEMOS)
+#halt // ERROR - HWSTEPGEN is only supported on PRO2ESP32DRV8825 and PRO2ESP32R3WEMOS
+#endif
+
 // ---------------------------------------------------------------------------
 // DRIVER BOARD CLASS : DO NOT CHANGE
 // ---------------------------------------------------------------------------
 extern volatile bool timerSemaphore;
 extern const char* DRVBRD_ID;
+#ifdef TIMEMOVESTART
+extern volatile uint32_t movecmdtime;                 // micros() when the move command was received
+extern volatile uint32_t firststeptime;               // micros() at the first step, set by the ISR
+#endif
+
+#ifdef STEPTIMING
+// snapshot of the step timing probe, see DriverBoard::getsteptiming()
+struct steptiming_t
+{
+  uint32_t samples;                             // ticks recorded since the last reset
+  uint32_t mhz;                                 // CPU cycles per uS
+  uint32_t latemax;                             // largest tick interval error in cycles
+  uint32_t isrmax;                              // longest ISR in cycles
+  uint32_t late[STEPTIMINGBINS];                // histogram of tick interval error
+  uint32_t isr[STEPTIMINGBINS];                 // histogram of ISR duration
+  uint32_t recent;                              // entries in recentlate and recentisr, oldest first
+  uint32_t recentlate[STEPTIMINGRING];
+  uint32_t recentisr[STEPTIMINGRING];
+};
+#endif
 
 class DriverBoard
 {
   public:
     DriverBoard(byte, unsigned long);           // constructor
     ~DriverBoard(void);                         // destructor
-    void initmove(bool, unsigned long, byte, bool, byte);
+    void initmove(bool, unsigned long, byte, bool, byte, unsigned long);
     void movemotor(byte, bool);
     void halt(void);
+    void inithomeswitch(void);
+    void sethomephase(byte);
+    bool gethomeedge(void);
+#ifdef STEPTIMING
+    void getsteptiming(steptiming_t*);
+    void resetsteptiming(void);
+#endif
     
     // getter
     int getstepmode(void);
     int getstepdelay(void);
+    int getaccel(void);
+    int getmaxspeeddelay(void);
     unsigned long getposition(void);
     
     // setter
     void setstepdelay(int);
+    void setaccel(int);
+    void setmaxspeeddelay(int);
     void setstepmode(int);
     void enablemotor(void);
     void releasemotor(void);
     void setposition(unsigned long);
     
   private:
+    unsigned long initramp(unsigned long);
+    void loadramp(void);
 #if ( DRVBRD == PRO2EULN2003   || DRVBRD == PRO2ESP32ULN2003  \
    || DRVBRD == PRO2EL298N     || DRVBRD == PRO2ESP32L298N    \
    || DRVBRD == PRO2EL293DMINI || DRVBRD == PRO2ESP32L293MINI \
@@ -302,7 +373,11 @@ class DriverBoard
     byte boardtype;                                 // DRVBRD
     int  stepmode;                                  // current step mode setting for board
     int  stepdelay;                                 // time in milliseconds to wait between pulses when moving
+    int  accel;                                     // acceleration in steps/s/s, 0 = no ramp, move at stepdelay
+    int  maxspeeddelay;                             // step interval in uS at top speed when ramping
     bool drvbrdleds;                                // true if DRVBRD supports INOUT leds - can be enabled/disabled
-    unsigned int clock_frequency;                   // clock frequency used to generate 2us delay for ESP32 160Mhz/240Mhz
+    unsigned int clock_frequency;                   // clock frequency in MHz, used to generate 2us delay
+    uint32_t pulsecycles;                           // CPU cycles for the DRV8825 STEP pulse width
+    byte lastdir;                                   // last value written to DIRPIN
 };
 #endif
@@ -119,6 +119,7 @@
 #endif
 #include <SPI.h>
 #include "FocuserSetupData.h"
+#include "hal.h"                            // time, gpio, file system and network used by the focuser core
 
 // --------------------------------------------------------------------------
 // 7: WIFI NETWORK SSID AND PASSWORD CONFIGURATION
@@ -219,20 +220,13 @@ BluetoothSerial SerialBT;                     // define BT adapter to use
 // Project specific includes - DO NOT CHANGE
 #if defined(BLUETOOTHMODE) || defined(LOCALSERIAL)
 #include "ESPQueue.h"                         // by Steven de Salas
-Queue queue(QUEUELENGTH);                     // receive serial queue of commands
-#ifdef LOCALSERIAL
-String serialline;                            // buffer for serial data
-#endif
-#ifdef BLUETOOTHMODE
-String btline;                                // buffer for serial data
-#endif
+Queue<QUEUELENGTH, CMDBUFFERSIZE - 1> queue;  // receive serial queue of commands, frames are built in place in the slots
 #endif // #if defined(BLUETOOTHMODE) || defined(LOCALSERIAL)
 
 #if defined(ACCESSPOINT) || defined(STATIONMODE)
 IPAddress ESP32IPAddress;
 String ServerLocalIP;
-WiFiServer myserver(SERVERPORT);
-WiFiClient myclient;                          // only one client supported, multiple connections denied
+haltcpserver_t myserver(SERVERPORT);
 IPAddress myIP;
 #endif // #if defined(ACCESSPOINT) || defined(STATIONMODE)
 
@@ -287,23 +281,14 @@ SetupData *mySetupData;                     // focuser data
 #include <WebServer.h>
 #endif // if defined(esp8266)
 
-#if defined(ESP8266)
-#undef DEBUG_ESP_HTTP_SERVER
-extern ESP8266WebServer mserver;
-#else
-extern WebServer mserver;
-#endif // if defined(esp8266)
+extern halhttpserver_t mserver;
 
 extern String MSpg;
 extern void start_management(void);
 extern void start_ascomremoteserver(void);
 extern void checkASCOMALPACADiscovery(void);
 
-#if defined(ESP8266)
-extern ESP8266WebServer *ascomserver;
-#else
-extern WebServer *ascomserver;
-#endif // if defined(esp8266)
+extern halhttpserver_t *ascomserver;
 
 extern void start_webserver(void);
 
@@ -323,7 +308,7 @@ bool HPS_alert()
 {
   if ( mySetupData->get_homepositionswitch() == 1)
   {
-    return !((bool)digitalRead(HPSWPIN));
+    return !((bool)halpinread(HPSWPIN));
   }
   else
   {
@@ -492,8 +477,8 @@ void init_joystick1(void)
 {
   // perform any inititalisations necessary
   // for future use
-  pinMode(JOYINOUTPIN, INPUT);
-  pinMode(JOYOTHERPIN, INPUT);
+  halpinmode(JOYINOUTPIN, INPUT);
+  halpinmode(JOYOTHERPIN, INPUT);
 }
 #endif // #ifdef JOYSTICK1
 
@@ -501,7 +486,7 @@ void init_joystick1(void)
 #ifdef JOYSTICK2
 void IRAM_ATTR joystick2sw_isr()
 {
-  joy2swstate = !(digitalRead(JOYOTHERPIN));      // joy2swstate will be 1 when switch is pressed
+  joy2swstate = !(halpinread(JOYOTHERPIN));       // joy2swstate will be 1 when switch is pressed
 }
 
 void update_joystick2(void)
@@ -547,8 +532,8 @@ void update_joystick2(void)
 
 void init_joystick2(void)
 {
-  pinMode(JOYINOUTPIN, INPUT);
-  pinMode(JOYOTHERPIN, INPUT_PULLUP);
+  halpinmode(JOYINOUTPIN, INPUT);
+  halpinmode(JOYOTHERPIN, INPUT_PULLUP);
   // setup interrupt, falling, when switch is pressed, pin falls from high to low
   attachInterrupt(JOYOTHERPIN, joystick2sw_isr, FALLING);
   joy2swstate = 0;
@@ -563,21 +548,21 @@ void init_joystick2(void)
 #ifdef PUSHBUTTONS
 void init_pushbuttons(void)
 {
-  pinMode(INPBPIN, INPUT);
-  pinMode(OUTPBPIN, INPUT);
+  halpinmode(INPBPIN, INPUT);
+  halpinmode(OUTPBPIN, INPUT);
 }
 
 void update_pushbuttons(void)
 {
   long newpos;
   // PB are active high - pins float low if unconnected
-  if ( digitalRead(INPBPIN) == 1 )                // is pushbutton pressed?
+  if ( halpinread(INPBPIN) == 1 )                 // is pushbutton pressed?
   {
     newpos = ftargetPosition - 1;
     newpos = (newpos < 0 ) ? 0 : newpos;
     ftargetPosition = newpos;
   }
-  if ( digitalRead(OUTPBPIN) == 1 )
+  if ( halpinread(OUTPBPIN) == 1 )
   {
     newpos = ftargetPosition + 1;
     // an unsigned long range is 0 to 4,294,967,295
@@ -620,7 +605,7 @@ void start_mdns_service(void)
     MDNS.addService("http", "tcp", MDNSSERVERPORT);
     mdnsserverstate = RUNNING;
   }
-  delay(10);                      // small pause so background tasks can run
+  haldelay(10);                   // small pause so background tasks can run
 }
 
 void stop_mdns_service(void)
@@ -640,7 +625,7 @@ void stop_mdns_service(void)
   {
     DebugPrintln(SERVERNOTRUNNINGSTR);
   }
-  delay(10);                      // small pause so background tasks can run
+  haldelay(10);                   // small pause so background tasks can run
 }
 #endif // #ifdef MDNSSERVER
 
@@ -655,12 +640,7 @@ void stop_mdns_service(void)
 #endif // if defined(esp8266)
 
 #include "webserver.h"
-#if defined(ESP8266)
-#undef DEBUG_ESP_HTTP_SERVER
-extern ESP8266WebServer *webserver;
-#else
-extern WebServer *webserver;
-#endif // if defined(esp8266)
+extern halhttpserver_t *webserver;
 
 // ----------------------------------------------------------------------------------------------
 // 25: OTAUPDATES - CHANGE AT YOUR OWN PERIL
@@ -730,11 +710,11 @@ void init_duckdns(void)
   DebugPrintln(SETUPDUCKDNSSTR);
   myoled->oledtextmsg(SETUPDUCKDNSSTR, -1, false, true);
   EasyDDNS.service("duckdns");                  // Enter your DDNS Service Name - "duckdns" / "noip"
-  delay(5);
+  haldelay(5);
   EasyDDNS.client(duckdnsdomain, duckdnstoken); // Enter ddns Domain & Token | Example - "esp.duckdns.org","1234567"
-  delay(5);
+  haldelay(5);
   EasyDDNS.update(DUCKDNS_REFRESHRATE);         // Check for New Ip Every 60 Seconds.
-  delay(5);
+  haldelay(5);
   duckdnsstate = RUNNING;
 }
 #endif // #ifdef USEDUCKSDNS
@@ -745,7 +725,7 @@ void init_duckdns(void)
 byte TimeCheck(unsigned long x, unsigned long Delay)
 {
   unsigned long y = x + Delay;
-  unsigned long z = millis();                           // pick current time
+  unsigned long z = halmillis();                        // pick current time
 
   if ((x > y) && (x < z))
     return 0;                                           // overflow y
@@ -760,40 +740,28 @@ extern void stop_management(void);
 void software_Reboot(int Reboot_delay)
 {
   myoled->oledtextmsg(WIFIRESTARTSTR, -1, true, false);
+  if ( isMoving == 1 )
+  {
+    driverboard->halt();                        // stop the motor so the settings can be written
+    mySetupData->ResumeSaves();
+  }
+  mySetupData->SaveConfiguration(driverboard->getposition(), mySetupData->get_focuserdirection());  // journal where the motor stopped
   mySetupData->SaveNow();                       // save the focuser settings immediately
 
   // a reboot causes everything to reset, so code to stop services etc is not really needed
-  delay(Reboot_delay);
+  haldelay(Reboot_delay);
   ESP.restart();
 }
 
-// move motor without updating position, used by sethomeposition
-void steppermotormove(byte dir )                // direction moving_in, moving_out ^ reverse direction
-{
-  if ( mySetupData->get_inoutledstate() == 1)
-  {
-#if (DRVBRD == PRO2ESP32ULN2003 || DRVBRD == PRO2ESP32L298N || DRVBRD == PRO2ESP32L293DMINI || DRVBRD == PRO2ESP32L9110S) || (DRVBRD == PRO2ESP32DRV8825 )
-    ( dir == moving_in ) ? digitalWrite(INLEDPIN, 1) : digitalWrite(OUTLEDPIN, 1);
-#endif
-  }
-  driverboard->movemotor(dir, false);
-  if ( mySetupData->get_inoutledstate() == 1)
-  {
-#if (DRVBRD == PRO2ESP32ULN2003 || DRVBRD == PRO2ESP32L298N || DRVBRD == PRO2ESP32L293DMINI || DRVBRD == PRO2ESP32L9110S) || (DRVBRD == PRO2ESP32DRV8825 )
-    ( dir == moving_in ) ? digitalWrite(INLEDPIN, 0) : digitalWrite(OUTLEDPIN, 0);
-#endif
-  }
-}
-
 void init_leds()
 {
   if ( mySetupData->get_inoutledstate() == 1)
   {
 #if (DRVBRD == PRO2ESP32ULN2003 || DRVBRD == PRO2ESP32L298N || DRVBRD == PRO2ESP32L293DMINI || DRVBRD == PRO2ESP32L9110S) || (DRVBRD == PRO2ESP32DRV8825 )
-    pinMode(INLEDPIN, OUTPUT);
-    pinMode(OUTLEDPIN, OUTPUT);
-    digitalWrite(INLEDPIN, 1);
-    digitalWrite(OUTLEDPIN, 1);
+    halpinmode(INLEDPIN, OUTPUT);
+    halpinmode(OUTLEDPIN, OUTPUT);
+    halpinwrite(INLEDPIN, 1);
+    halpinwrite(OUTLEDPIN, 1);
 #endif
   }
 }
@@ -808,7 +776,8 @@ void init_homepositionswitch()
 {
   if ( mySetupData->get_homepositionswitch() == 1)
   {
-    pinMode(HPSWPIN, INPUT_PULLUP);
+    halpinmode(HPSWPIN, INPUT_PULLUP);
+    driverboard->inithomeswitch();
   }
 }
 
@@ -932,14 +901,16 @@ void setup()
 
 #ifdef LOCALSERIAL
   Serial.begin(SERIALPORTSPEED);
-  serialline = "";
   clearSerialPort();
+#if defined(ESP32)
+  start_commsrxtask();
+#endif
 #endif // if defined(LOCALSERIAL)
 
 #ifdef BLUETOOTHMODE                            // open Bluetooth port, set bluetooth device name
   SerialBT.begin(BLUETOOTHNAME);                // Bluetooth device name
-  btline = "";
   clearbtPort();
+  start_commsrxtask();
   DebugPrintln(BLUETOOTHSTARTSTR);
 #endif
 
@@ -1049,6 +1020,10 @@ void setup()
   DebugPrintln(mySetupData->get_temperatureprobestate());
   DebugPrint(F("In/Out LED's state="));
   DebugPrintln(mySetupData->get_inoutledstate());
+  DebugPrint(F("motoraccel= "));
+  DebugPrintln(mySetupData->get_motoraccel());
+  DebugPrint(F("maxspeeddelay= "));
+  DebugPrintln(mySetupData->get_maxspeeddelay());
 
   tprobe1 = 0;
   lasttemp = 20.0;
@@ -1263,6 +1238,14 @@ void setup()
     driverboard->setstepdelay(mySetupData->get_motorspeeddelay());
   }
 
+  // acceleration ramp, maxspeeddelay of 0 means it has not been set
+  if ( mySetupData->get_maxspeeddelay() == 0 )
+  {
+    mySetupData->set_maxspeeddelay(driverboard->getstepdelay());
+  }
+  driverboard->setmaxspeeddelay(mySetupData->get_maxspeeddelay());
+  driverboard->setaccel(mySetupData->get_motoraccel());
+
   // set coilpower
   DebugPrintln(CHECKCPWRSTR);
   if (mySetupData->get_coilpower() == 0)
@@ -1374,7 +1357,7 @@ void loop()
   static uint32_t backlash_count = 0;
   static bool DirOfTravel = (bool) mySetupData->get_focuserdirection();
   static uint32_t TimeStampDelayAfterMove = 0;
-  static uint32_t TimeStampPark = millis();
+  static uint32_t TimeStampPark = halmillis();
   static bool Parked = mySetupData->get_coilpower();
   static uint8_t updatecount = 0;
   static uint32_t steps = 0;
@@ -1382,52 +1365,26 @@ void loop()
   static connection_status ConnectionStatus = disconnected;
   static oled_state oled = oled_on;
 
-  int stepstaken = 0;
-  bool hpswstate = false;
-
 #ifdef TIMELOOP
   Serial.print("loop(): ");
-  Serial.println(millis());
+  Serial.println(halmillis());
 #endif
 
 #if defined(ACCESSPOINT) || defined(STATIONMODE)
-  if (ConnectionStatus == disconnected)
+  // serve up to MAXTCPCLIENTS clients, the display shows connected while any are
+  if ( ESP_TCPClients() )
   {
-    myclient = myserver.available();
-    if (myclient)
-    {
-      DebugPrintln(TCPCLIENTCONNECTSTR);
-      if (myclient.connected())
-      {
-        ConnectionStatus = connected;
-      }
-    }
+    ConnectionStatus = connected;
   }
-  else
+  else if (ConnectionStatus == connected)
   {
-    // is data available from the client request
-    if (myclient.connected())
-    {
-      if (myclient.available())
-      {
-        ESP_Communication(); // Wifi communication
-      }
-    }
-    else
-    {
-      DebugPrintln(TCPCLIENTDISCONNECTSTR);
-      myclient.stop();
-      ConnectionStatus = disconnected;
-      oled = oled_on;
-    }
+    ConnectionStatus = disconnected;
+    oled = oled_on;
   }
 #endif // defined(ACCESSPOINT) || defined(STATIONMODE)
 
 #ifdef BLUETOOTHMODE
-  if ( SerialBT.available() )
-  {
-    processbt();
-  }
+  // commsrxtask reads the bluetooth port
   // if there is a command from Bluetooth
   if ( queue.count() >= 1 )                 // check for serial command
   {
@@ -1436,14 +1393,16 @@ void loop()
 #endif // ifdef Bluetoothmode
 
 #ifdef LOCALSERIAL
-  // if there is a command from Serial port
+  // if there is a command from Serial port, on the ESP32 commsrxtask reads the port
+#if defined(ESP8266)
   if ( Serial.available() )
   {
     processserial();
   }
+#endif
   if ( queue.count() >= 1 )                 // check for serial command
   {
-    halt_alert = ESP_Communication();
+    ESP_Communication();
   }
 #endif // ifdef LOCALSERIAL
 
@@ -1605,53 +1564,18 @@ void loop()
       // if target pos < current pos then steps = current pos - target pos
       steps = (ftargetPosition > driverboard->getposition()) ? ftargetPosition - driverboard->getposition() : driverboard->getposition() - ftargetPosition;
 
-      // Error - cannot combine backlash steps to steps because that alters position
       // Backlash move SHOULD NOT alter focuser position as focuser is not actually moving
       // backlash is taking up the slack in the stepper motor/focuser mechanism, so position is not actually changing
-      if ( backlash_count != 0 )
-      {
-        MainStateMachine = State_Backlash;
-      }
-      else
-      {
-        // if target pos > current pos then steps = target pos - current pos
-        // if target pos < current pos then steps = current pos - target pos
-        driverboard->initmove(DirOfTravel, steps, mySetupData->get_motorSpeed(), mySetupData->get_inoutledstate(), mySetupData->get_reversedirection());
-        DebugPrint("Steps: ");
-        DebugPrintln(steps);
-        MainStateMachine = State_Moving;
-      }
-      break;
-
-    case State_Backlash:
-      // apply backlash
-      DebugPrint("Apply Backlash: Steps=");
+      // the driverboard takes the backlash steps first, timed by the ISR, without updating position
+      // settings are not written to flash during the move, waits here if a save is in progress
+      mySetupData->PauseSaves();
+      driverboard->initmove(DirOfTravel, steps, mySetupData->get_motorSpeed(), mySetupData->get_inoutledstate(), mySetupData->get_reversedirection(), backlash_count);
+      DebugPrint("Steps: ");
+      DebugPrint(steps);
+      DebugPrint(" Backlash: ");
       DebugPrintln(backlash_count);
-      while ( backlash_count != 0 )
-      {
-        steppermotormove(DirOfTravel);                            // take 1 step and do not adjust position
-        delayMicroseconds(driverboard->getstepdelay());           // ensure delay between steps
-        backlash_count--;
-        if (HPS_alert() )                                         // check if home position sensor activated?
-        {
-          DebugPrintln("HPS_alert() during backlash move");
-          timerSemaphore = false;                                 // move finished
-          backlash_count = 0;                                     // drop out of while loop
-          MainStateMachine = State_Moving;                        // change state to State_Moving and handle HPSW
-        }
-      }
-      if ( MainStateMachine == State_Backlash )                   // finished backlash move, so now move motor #steps
-      {
-        DebugPrintln("Backlash done");
-        DebugPrint("Initiate motor move- steps: ");
-        DebugPrintln(steps);
-        driverboard->initmove(DirOfTravel, steps, mySetupData->get_motorSpeed(), mySetupData->get_inoutledstate(), mySetupData->get_reversedirection());
-        MainStateMachine = State_Moving;
-      }
-      else
-      {
-        // MainStateMachine is State_Moving - timerSemaphore is false. is then caught by if(HPS_alert() ) and HPSW is processed
-      }
+      ESP_Notify(NOTIFYMOVESTART);
+      MainStateMachine = State_Moving;
       break;
 
     //_______________________________State_Moving
@@ -1661,10 +1585,35 @@ void loop()
       if ( timerSemaphore == true )
       {
         // move has completed, the driverboard keeps track of focuser position
-        DebugPrintln("Move completed");
-        DebugPrintln("Going to State_DelayAfterMove");
-        MainStateMachine = State_DelayAfterMove;
-        DebugPrintln(STATEDELAYAFTERMOVE);
+#ifdef TIMEMOVESTART
+        Serial.print("movestart(): ");
+        Serial.println(firststeptime - movecmdtime);
+#endif
+        if ( (DirOfTravel == moving_in) && HPS_alert() )
+        {
+          // the timer ISR stopped the move on the home position switch
+          DebugPrintln(STATESETHOMEPOSITION);
+          MainStateMachine = State_SetHomePosition;
+        }
+#if defined(HWSTEPGEN)
+        else if ( (DirOfTravel == moving_out) ? (driverboard->getposition() > ftargetPosition) : (driverboard->getposition() < ftargetPosition) )
+        {
+          // LEDC stepped past the target before it could be stopped, step back to it without backlash
+          // and without changing the focuser direction, so State_Idle does not start a reverse move
+          steps = (DirOfTravel == moving_out) ? driverboard->getposition() - ftargetPosition : ftargetPosition - driverboard->getposition();
+          DebugPrint("Overshoot: ");
+          DebugPrintln(steps);
+          driverboard->initmove(!DirOfTravel, steps, mySetupData->get_motorSpeed(), mySetupData->get_inoutledstate(), mySetupData->get_reversedirection(), 0);
+        }
+#endif
+        else
+        {
+          DebugPrintln("Move completed");
+          ESP_Notify(NOTIFYMOVEDONE);
+          DebugPrintln("Going to State_DelayAfterMove");
+          MainStateMachine = State_DelayAfterMove;
+          DebugPrintln(STATEDELAYAFTERMOVE);
+        }
       }
       else
       {
@@ -1676,36 +1625,23 @@ void loop()
           ftargetPosition = driverboard->getposition();
           mySetupData->set_fposition(driverboard->getposition());
           driverboard->halt();                            // disable interrupt timer that moves motor
+          ESP_Notify(NOTIFYHALTED);
           // we no longer need to keep track of steps here or halt because driverboard updates position on every move
           DebugPrintln("Going to State_DelayAfterMove");
           MainStateMachine = State_DelayAfterMove;
           DebugPrintln(STATEDELAYAFTERMOVE);
         } // if ( halt_alert )
-        if (HPS_alert() )                                 // check if home position sensor activated?
+        else if ( (DirOfTravel == moving_in) && HPS_alert() )
         {
-          if (driverboard->getposition() > 0)
-          {
-            DebugPrintln(HPCLOSEDFPNOT0STR);
-          }
-          else
-          {
-            DebugPrintln(HPCLOSEDFP0STR);
-          } // if (driverboard->getposition() > 0)
+          // switch was already closed when the move started, the ISR takes no step and will not signal completion
+          driverboard->halt();
           DebugPrintln(STATESETHOMEPOSITION);
-          ftargetPosition = 0;
-          driverboard->setposition(0);
-          mySetupData->set_fposition(0);
-
-          if ( mySetupData->get_showhpswmsg() == 1)     // check if display home position messages is enabled
-          {
-            if (mySetupData->get_displayenabled() == 1)
-            {
-              myoled->oledtextmsg(HPCLOSEDFP0STR, -1, true, true);
-            }
-          }
-          // we should jump to
           MainStateMachine = State_SetHomePosition;
         } // if (HPS_alert() )
+        else
+        {
+          ESP_Notify(NOTIFYPOSITION);                     // subscribers get a frame every interval steps
+        }
 
         // if the update position on display when moving is enabled, then update the display
         if ( mySetupData->get_lcdupdateonmove() == 1)
@@ -1724,10 +1660,18 @@ void loop()
       }
       break;
 
-    case State_SetHomePosition:                         // move out till home position switch opens
+    case State_SetHomePosition:                         // home position switch closed while moving in
       DebugPrintln("State_SetHomePosition");
       if ( mySetupData->get_homepositionswitch() == 1)
       {
+        if (driverboard->getposition() > 0)
+        {
+          DebugPrintln(HPCLOSEDFPNOT0STR);
+        }
+        else
+        {
+          DebugPrintln(HPCLOSEDFP0STR);
+        } // if (driverboard->getposition() > 0)
         // check if display home position switch messages is enabled
         if ( mySetupData->get_showhpswmsg() == 1)
         {
@@ -1736,44 +1680,88 @@ void loop()
             myoled->oledtextmsg(HPMOVETILLOPENSTR, -1, false, true);
           }
         }
-        // HOME POSITION SWITCH IS CLOSED - Step out till switch opens then set position = 0
-        stepstaken = 0;                                   // Count number of steps to prevent going too far
+        // HOME POSITION SWITCH IS CLOSED - Step out till switch opens, the switch interrupt stops the move
+        // HOMESTEPS limits the move if the hpsw is not connected or is faulty
         DebugPrintln(HPMOVETILLOPENSTR);
-        DirOfTravel = !DirOfTravel;                       // We were going in, now we need to reverse and go out
-        hpswstate = HPSWCLOSED;                           // We know we got here because switch was closed
-        while ( hpswstate == HPSWCLOSED )
-        {
-          if ( mySetupData->get_reversedirection() == 0 )
-          {
-            steppermotormove(DirOfTravel);                // take 1 step
-          }
-          else
-          {
-            steppermotormove(!DirOfTravel);
-          }
+        driverboard->setposition(0);
+        DirOfTravel = moving_out;
+        driverboard->sethomephase(HOMEBACKOFF);
+        driverboard->initmove(DirOfTravel, HOMESTEPS, mySetupData->get_motorSpeed(), mySetupData->get_inoutledstate(), mySetupData->get_reversedirection(), 0);
+        MainStateMachine = State_HomeBackOff;
+      }
+      else
+      {
+        ESP_Notify(NOTIFYMOVEDONE);
+        MainStateMachine = State_DelayAfterMove;
+        TimeStampDelayAfterMove = halmillis();
+        DebugPrintln(STATEDELAYAFTERMOVE);
+      } //  if( mySetupData->get_homepositionswitch() == 1)
+      break;
 
-          delayMicroseconds(driverboard->getstepdelay()); // Ensure delay between steps
+    case State_HomeBackOff:                             // moving out till home position switch opens
+      if ( timerSemaphore == true )
+      {
+        DebugPrint(F(HPMOVEOUTSTEPSSTR));
+        DebugPrintln(driverboard->getposition());
+        if ( driverboard->gethomeedge() == false )
+        {
+          // moved HOMESTEPS and the switch did not open
+          DebugPrintln(HPMOVEOUTERRORSTR);
+          driverboard->sethomephase(HOMEIDLE);
+          ftargetPosition = 0;
+          driverboard->setposition(0);
+          mySetupData->set_fposition(0);
+          mySetupData->set_focuserdirection(DirOfTravel);
+          ESP_Notify(NOTIFYHOMEERROR);
+          MainStateMachine = State_DelayAfterMove;
+          TimeStampDelayAfterMove = halmillis();
+          DebugPrintln(STATEDELAYAFTERMOVE);
+        }
+        else
+        {
+          // switch opened, come back in slowly and take the closing edge as position 0
+          DebugPrintln(HPMOVETILLCLOSEDSTR);
+          DirOfTravel = moving_in;
+          driverboard->sethomephase(HOMEAPPROACH);
+          driverboard->initmove(DirOfTravel, HOMESTEPS, SLOW, mySetupData->get_inoutledstate(), mySetupData->get_reversedirection(), 0);
+          MainStateMachine = State_HomeApproach;
+        }
+      }
+      else if ( halt_alert )
+      {
+        DebugPrintln("halt_alert");
+        halt_alert = false;
+        driverboard->halt();
+        driverboard->sethomephase(HOMEIDLE);
+        ftargetPosition = driverboard->getposition();
+        mySetupData->set_fposition(driverboard->getposition());
+        ESP_Notify(NOTIFYHALTED);
+        MainStateMachine = State_DelayAfterMove;
+        TimeStampDelayAfterMove = halmillis();
+        DebugPrintln(STATEDELAYAFTERMOVE);
+      }
+      break;
 
-          stepstaken++;                                   // increment steps taken
-          if ( stepstaken > HOMESTEPS )                   // this prevents the endless loop if the hpsw is not connected or is faulty
-          {
-            DebugPrintln(HPMOVEOUTERRORSTR);
-            hpswstate = HPSWOPEN;
-          }
-          else
-          {
-            hpswstate = !(digitalRead(HPSWPIN));          // read state of HPSW
-          }
+    case State_HomeApproach:                            // moving in slowly till home position switch closes
+      if ( (timerSemaphore == false) && HPS_alert() )
+      {
+        // switch closed again before the first step, the ISR takes no step and will not signal completion
+        driverboard->halt();
+        timerSemaphore = true;
+      }
+      if ( timerSemaphore == true )
+      {
+        if ( (driverboard->gethomeedge() == false) && !HPS_alert() )
+        {
+          DebugPrintln(HPMOVEINERRORSTR);
         }
-        DebugPrint(F(HPMOVEOUTSTEPSSTR));
-        DebugPrintln(stepstaken);
-        DebugPrintln(F(HPMOVEOUTFINISHEDSTR));
+        driverboard->sethomephase(HOMEIDLE);
         ftargetPosition = 0;
         driverboard->setposition(0);
         mySetupData->set_fposition(0);
-
         mySetupData->set_focuserdirection(DirOfTravel);   // set direction of last move
-
+        DebugPrintln(F(HPMOVEOUTFINISHEDSTR));
+        ESP_Notify(NOTIFYHOMED);
         if ( mySetupData->get_showhpswmsg() == 1)         // check if display home position switch messages is enabled
         {
           if (mySetupData->get_displayenabled() == 1)
@@ -1781,10 +1769,23 @@ void loop()
             myoled->oledtextmsg(HPMOVEOUTFINISHEDSTR, -1, true, true);
           }
         }
-      } //  if( mySetupData->get_homepositionswitch() == 1)
-      MainStateMachine = State_DelayAfterMove;
-      TimeStampDelayAfterMove = millis();
-      DebugPrintln(STATEDELAYAFTERMOVE);
+        MainStateMachine = State_DelayAfterMove;
+        TimeStampDelayAfterMove = halmillis();
+        DebugPrintln(STATEDELAYAFTERMOVE);
+      }
+      else if ( halt_alert )
+      {
+        DebugPrintln("halt_alert");
+        halt_alert = false;
+        driverboard->halt();
+        driverboard->sethomephase(HOMEIDLE);
+        ftargetPosition = driverboard->getposition();
+        mySetupData->set_fposition(driverboard->getposition());
+        ESP_Notify(NOTIFYHALTED);
+        MainStateMachine = State_DelayAfterMove;
+        TimeStampDelayAfterMove = halmillis();
+        DebugPrintln(STATEDELAYAFTERMOVE);
+      }
       break;
 
     //_______________________________State_DelayAfterMove
@@ -1797,7 +1798,8 @@ void loop()
       {
         oled = oled_on;
         isMoving = 0;
-        TimeStampPark  = millis();                      // catch current time
+        mySetupData->ResumeSaves();                     // write any settings saved during the move
+        TimeStampPark  = halmillis();                   // catch current time
         Parked = false;                                 // mark to park the motor in State_Idle
         MainStateMachine = State_Idle;
         DebugPrint(">State_Idle ");
@@ -1812,6 +1814,6 @@ void loop()
 
 #ifdef TIMELOOP
   Serial.print("loop(): ");
-  Serial.println(millis());
+  Serial.println(halmillis());
 #endif
 } // end Loop()
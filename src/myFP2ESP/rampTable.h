@@ -0,0 +1,175 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP ACCELERATION RAMP TABLES
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+// The ramp tables are generated by the compiler from STEPSPERREVOLUTION, RAMPSTARTRPM and the
+// step mode, so no float math is needed at run time. Only C++11 constexpr is used so this builds
+// with the older ESP8266 and ESP32 cores.
+//
+// Entry i of the table for a step mode is the interval in uS before step i+1 of a move that
+// starts from rest at constant acceleration rampaccel(stepmode), ie
+//   v(i) = sqrt(2 * a * (i + 1))   d(i) = d0 / sqrt(i + 1)
+// where d0 is the step interval at RAMPSTARTRPM. A move with acceleration accel walks the
+// table with a fixed point index increment of (accel << RAMPFRACBITS) / rampaccel(stepmode).
+
+#ifndef rampTable_h
+#define rampTable_h
+
+#include <stdint.h>
+
+// ---------------------------------------------------------------------------
+// 1: RAMP PROFILE
+// ---------------------------------------------------------------------------
+
+// step interval in uS at RAMPSTARTRPM, the first entry of the table for this step mode
+constexpr uint32_t rampd0(uint32_t stepmode)
+{
+  return ( (60000000UL / ((uint32_t) RAMPSTARTRPM * STEPSPERREVOLUTION * stepmode)) < 1 ) ? 1 :
+         ( 60000000UL / ((uint32_t) RAMPSTARTRPM * STEPSPERREVOLUTION * stepmode) );
+}
+
+// acceleration of the table in steps/s/s, a = v0^2 / 2 where v0 = 1000000 / d0
+constexpr uint32_t rampaccel(uint32_t stepmode)
+{
+  return ( (500000000000ULL / ((uint64_t) rampd0(stepmode) * rampd0(stepmode))) < 1 ) ? 1 :
+         (uint32_t) (500000000000ULL / ((uint64_t) rampd0(stepmode) * rampd0(stepmode)));
+}
+
+// integer square root, binary search between lo and hi
+constexpr uint64_t rampisqrt(uint64_t n, uint64_t lo = 0, uint64_t hi = 0xFFFFFFFFULL)
+{
+  return ( lo >= hi ) ? lo :
+         ( ((lo + hi + 1) / 2) * ((lo + hi + 1) / 2) <= n ) ? rampisqrt(n, (lo + hi + 1) / 2, hi)
+         : rampisqrt(n, lo, (lo + hi + 1) / 2 - 1);
+}
+
+// entries are held as uint16_t, the slow start of a ramp is clamped to 65535uS
+constexpr uint16_t rampclamp(uint64_t sdelay)
+{
+  return ( sdelay > 0xFFFF ) ? 0xFFFF : ( sdelay < 1 ) ? 1 : (uint16_t) sdelay;
+}
+
+// d0 / sqrt(i + 1) rounded to the nearest uS
+constexpr uint16_t rampdelay(uint32_t d0, uint32_t i)
+{
+  return rampclamp( (rampisqrt((uint64_t) d0 * d0 * 4 / (i + 1)) + 1) / 2 );
+}
+
+// ---------------------------------------------------------------------------
+// 2: TABLE GENERATION
+// ---------------------------------------------------------------------------
+
+struct ramptable_t
+{
+  uint16_t sdelay[RAMPTABLESIZE];
+};
+
+// index sequence 0..N-1, built by halves so the template depth stays at log2(N)
+template<unsigned... I> struct rampseq
+{
+  typedef rampseq type;
+};
+
+template<class A, class B> struct rampcat;
+
+template<unsigned... A, unsigned... B> struct rampcat<rampseq<A...>, rampseq<B...>> : rampseq<A..., (sizeof...(A) + B)...> {};
+
+template<unsigned N> struct rampmakeseq : rampcat<typename rampmakeseq<N / 2>::type, typename rampmakeseq<N - N / 2>::type> {};
+
+template<> struct rampmakeseq<0> : rampseq<> {};
+
+template<> struct rampmakeseq<1> : rampseq<0> {};
+
+template<unsigned... I> constexpr ramptable_t rampbuild(uint32_t d0, rampseq<I...>)
+{
+  return ramptable_t{ { rampdelay(d0, I)... } };
+}
+
+constexpr ramptable_t ramptable(uint32_t stepmode)
+{
+  return rampbuild(rampd0(stepmode), rampmakeseq<RAMPTABLESIZE>::type());
+}
+
+// ---------------------------------------------------------------------------
+// 3: TABLE CHECKS
+// ---------------------------------------------------------------------------
+
+// entry i matches the analytic profile to within 1/2 uS, (2d - 1)^2 (i + 1) <= 4 d0^2 <= (2d + 1)^2 (i + 1)
+// and is not longer than the entry before it. Split in halves to stay inside the constexpr depth limit
+constexpr bool rampentryok(uint32_t d0, uint32_t i)
+{
+  return ( rampdelay(d0, i) == 0xFFFF ) || ( rampdelay(d0, i) == 1 ) ||
+         ( ((2ULL * rampdelay(d0, i) - 1) * (2ULL * rampdelay(d0, i) - 1) * (i + 1) <= 4ULL * d0 * d0)
+           && (4ULL * d0 * d0 <= (2ULL * rampdelay(d0, i) + 1) * (2ULL * rampdelay(d0, i) + 1) * (i + 1))
+           && ( (i == 0) || (rampdelay(d0, i) <= rampdelay(d0, i - 1)) ) );
+}
+
+constexpr bool rampcheck(uint32_t d0, uint32_t first, uint32_t last)
+{
+  return ( first == last ) ? rampentryok(d0, first) :
+         ( rampcheck(d0, first, first + (last - first) / 2) && rampcheck(d0, first + (last - first) / 2 + 1, last) );
+}
+
+constexpr bool ramptableok(uint32_t stepmode)
+{
+  return ( rampdelay(rampd0(stepmode), 0) == rampclamp(rampd0(stepmode)) )
+         && rampcheck(rampd0(stepmode), 0, RAMPTABLESIZE - 1);
+}
+
+// ---------------------------------------------------------------------------
+// 4: RAMP FOR A MOVE
+// ---------------------------------------------------------------------------
+
+// fixed point indexes into a ramp table for one move, see rampplan()
+struct rampplan_t
+{
+  uint32_t first;                               // index of the start speed
+  uint32_t top;                                 // index of the top speed
+  uint32_t inc;                                 // index increment per step
+};
+
+// plan a ramp from startdelay to topdelay uS on table, whose acceleration is tableaccel steps/s/s.
+// Returns false when the move runs at startdelay without a ramp: no acceleration, the start speed
+// is already the top speed, or the start is slower than the first entry of the table, which would
+// make the second step a jump to the table's start speed
+inline bool rampplan(const uint16_t* table, uint32_t tableaccel, uint32_t accel, uint32_t startdelay, uint32_t topdelay, rampplan_t* plan)
+{
+  if ( (accel == 0) || (topdelay >= startdelay) || (startdelay > table[0]) )
+  {
+    return false;
+  }
+
+  // table is in descending order, find the first entries at or below the start and top speed intervals
+  uint32_t first = 0;
+  uint32_t top = 0;
+  for ( uint32_t bit = RAMPTABLESIZE / 2; bit > 0; bit >>= 1 )
+  {
+    if ( ((first + bit) < RAMPTABLESIZE) && (table[first + bit - 1] > startdelay) )
+    {
+      first += bit;
+    }
+    if ( ((top + bit) < RAMPTABLESIZE) && (table[top + bit - 1] > topdelay) )
+    {
+      top += bit;
+    }
+  }
+  if ( top <= first )
+  {
+    return false;                               // start speed is already at the top of the table
+  }
+
+  uint64_t inc = (((uint64_t) accel << RAMPFRACBITS) + tableaccel / 2) / tableaccel;
+  plan->first = first << RAMPFRACBITS;
+  plan->top = top << RAMPFRACBITS;
+  plan->inc = (inc < 1) ? 1 : (inc > ((uint64_t) RAMPTABLESIZE << RAMPFRACBITS)) ? ((uint32_t) RAMPTABLESIZE << RAMPFRACBITS) : (uint32_t) inc;
+  return true;
+}
+
+#endif
@@ -0,0 +1,157 @@
+// ---------------------------------------------------------------------------
+// TITLE: myFP2ESP TIMER ISR STEPPING
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// COPYRIGHT
+// ---------------------------------------------------------------------------
+// (c) Copyright Robert Brown 2014-2021. All Rights Reserved.
+// (c) Copyright Holger M, 2019-2021. All Rights Reserved.
+// ---------------------------------------------------------------------------
+
+// What the motor timer ISR and the home position switch ISR decide on each interrupt: backlash steps
+// first, then the move, the ramp, and stopping on the home position switch. The ISRs in myBoards.cpp
+// only add the hardware, the STEP pulse and reloading or disarming the timer. The host build
+// (Test-Programs/HOSTBUILD) includes this file too, so its tests run the same code. There are no
+// hardware dependencies here, include it after generalDefinitions.h, myBoards.h and rampTable.h.
+
+#ifndef stepTimer_h
+#define stepTimer_h
+
+#include <stdint.h>
+
+#define STEPTIMER_INLINE inline __attribute__((always_inline))
+
+// ---------------------------------------------------------------------------
+// 1: MOVE STATE, DEFINED BY THE DRIVER BOARD CODE
+// ---------------------------------------------------------------------------
+
+extern volatile bool timerSemaphore;                  // set when a move has completed
+extern volatile uint32_t stepcount;                   // steps still to take
+extern volatile uint32_t backlashcount;               // backlash steps to take before stepcount
+extern volatile bool stepjob;                         // a step was taken since the timer was armed
+extern bool stepdir;
+extern volatile byte homephase;
+extern volatile bool homeedge;                        // edge for the phase was seen
+
+// rampidx, rampfirst and ramptop are fixed point indexes into activeramp with RAMPFRACBITS fraction bits
+extern uint16_t activeramp[RAMPTABLESIZE];
+extern uint32_t activerampaccel;                      // acceleration of activeramp in steps/s/s
+extern volatile uint32_t rampinc;                     // index increment per step, 0 = no ramp
+extern volatile uint32_t rampidx;                     // current index
+extern volatile uint32_t rampfirst;                   // index of the start speed
+extern volatile uint32_t ramptop;                     // index of the top speed
+extern volatile uint32_t rampsteps;                   // steps taken while accelerating
+
+// ---------------------------------------------------------------------------
+// 2: RAMP
+// ---------------------------------------------------------------------------
+
+// set up the ramp for a move starting at startdelay uS with acceleration accel, topdelay is the
+// interval at top speed. Returns false if the move runs at startdelay without a ramp
+STEPTIMER_INLINE bool rampstart(uint32_t accel, uint32_t startdelay, uint32_t topdelay)
+{
+  rampplan_t plan;
+  rampinc = 0;
+  rampsteps = 0;
+  if ( (accel == 0) || !rampplan(activeramp, activerampaccel, accel, startdelay, topdelay, &plan) )
+  {
+    return false;
+  }
+  rampfirst = plan.first;
+  rampidx = rampfirst;
+  ramptop = plan.top;
+  rampinc = plan.inc;
+  return true;
+}
+
+// return the interval in uS to wait before the next step, stepcount must already be updated
+// accelerate until ramptop, then cruise, then decelerate over the same number of steps taken to accelerate
+STEPTIMER_INLINE uint32_t nextstepdelay(void)
+{
+  if ( stepcount <= rampsteps )
+  {
+    rampidx = ( (rampidx - rampfirst) > rampinc ) ? (rampidx - rampinc) : rampfirst;
+  }
+  else if ( rampidx < ramptop )
+  {
+    rampidx = ( (ramptop - rampidx) > rampinc ) ? (rampidx + rampinc) : ramptop;
+    rampsteps++;
+  }
+  return activeramp[rampidx >> RAMPFRACBITS];
+}
+
+// ---------------------------------------------------------------------------
+// 3: TIMER TICK
+// ---------------------------------------------------------------------------
+
+/*
+  backlashcount steps are taken first, without updating position, then stepcount steps
+  stepcount   HPS_altert    stepdir           action
+  ----------------------------------------------------
+    0           x             x             stop
+    >0        false           x             step
+    !0        true        moving_in         stop
+    !0        true        moving_out        step
+*/
+#define STEPTICKBACKLASH  0             // take a step without updating the position
+#define STEPTICKSTEP      1             // take a step and update the position, then reload the timer with nextstepdelay() if rampinc
+#define STEPTICKSTOP      2             // no step, disarm the timer then call stepstopped()
+
+// called on each timer tick with the home position switch state, the counters are updated for the step
+STEPTIMER_INLINE byte steptick(bool hpsclosed)
+{
+  bool blocked = hpsclosed && (stepdir == moving_in);
+  if ( backlashcount && !blocked )
+  {
+    backlashcount--;
+    stepjob = true;
+    return STEPTICKBACKLASH;
+  }
+  if ( stepcount && !blocked )
+  {
+    stepcount--;
+    stepjob = true;
+    return STEPTICKSTEP;
+  }
+  return STEPTICKSTOP;
+}
+
+// the timer is disarmed, signal the move complete if it took a step. A tick left over from a move
+// that already completed does not signal again
+STEPTIMER_INLINE void stepstopped(void)
+{
+  if ( stepjob == true )
+  {
+    stepcount = 0;                      // just in case HPS_alert was fired up
+    backlashcount = 0;
+    stepjob = false;
+    timerSemaphore = true;
+  }
+}
+
+// end the move without another step, the next tick returns STEPTICKSTOP
+STEPTIMER_INLINE void stepstop(void)
+{
+  backlashcount = 0;
+  stepcount = 0;
+}
+
+// ---------------------------------------------------------------------------
+// 4: HOME POSITION SWITCH
+// ---------------------------------------------------------------------------
+
+// called from the switch interrupt, returns true if the edge is the one the current homing phase
+// stops on. Steps stop at the edge, so the focuser position at that moment is the switch position
+STEPTIMER_INLINE bool homeswitchedge(bool closed)
+{
+  if ( ((homephase == HOMEBACKOFF) && !closed) || ((homephase == HOMEAPPROACH) && closed) )
+  {
+    homeedge = true;
+    homephase = HOMEIDLE;
+    return true;
+  }
+  return false;
+}
+
+#endif
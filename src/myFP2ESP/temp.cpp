@@ -14,6 +14,7 @@
 // ----------------------------------------------------------------------------------------------
 
 #include <Arduino.h>
+#include "hal.h"
 #include "FocuserSetupData.h"
 #include "generalDefinitions.h"
 #include "myBoards.h"
@@ -50,7 +51,7 @@ void TempProbe::start_temp_probe()
 {
   DebugPrintln("start_temp_probe()");
   tprobe1 = false;
-  pinMode(TEMPPIN, INPUT);                      // Configure GPIO pin for temperature probe
+  halpinmode(TEMPPIN, INPUT);                   // Configure GPIO pin for temperature probe
   DebugPrintln(CHECKFORTPROBESTR);
   DebugPrintln("start_temp_probe(): begin");
   begin();
@@ -136,7 +137,7 @@ void TempProbe::update_temp(void)
     {
       static unsigned long lasttempconversion = 0;
       static byte requesttempflag = 0;                  // start with request
-      unsigned long tempnow = millis();
+      unsigned long tempnow = halmillis();
 
       // see if the temperature needs updating - done automatically every 1.5s
       if (TimeCheck(lasttempconversion, TEMPREFRESHRATE))   // see if the temperature needs updating